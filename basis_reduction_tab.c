@@ -39,6 +39,13 @@ struct tab_lp {
 #define GBR_set(a,b)			    mpq_set(a,b)
 #define GBR_set_ui(a,b)			    mpq_set_ui(a,b,1)
 #define GBR_mul(a,b,c)			    mpq_mul(a,b,c)
+#define GBR_add(a,b,c)			    mpq_add(a,b,c)
+#define GBR_sub(a,b,c)			    mpq_sub(a,b,c)
+#define GBR_sub_int(a,b,c)						\
+	do {								\
+		mpq_set_z(a, c);					\
+		mpq_sub(a, b, a);					\
+	} while (0)
 #define GBR_lt(a,b)			    (mpq_cmp(a,b) < 0)
 #define GBR_is_zero(a)			    (mpq_sgn(a) == 0)
 #define GBR_numref(a)			    mpq_numref(a)
@@ -58,6 +65,8 @@ struct tab_lp {
 #define GBR_set(a,b)			    mp_rat_copy(b,a)
 #define GBR_set_ui(a,b)			    mp_rat_set_uvalue(a,b,1)
 #define GBR_mul(a,b,c)			    mp_rat_mul(b,c,a)
+#define GBR_add(a,b,c)			    mp_rat_add(b,c,a)
+#define GBR_sub(a,b,c)			    mp_rat_sub(b,c,a)
 #define GBR_lt(a,b)			    (mp_rat_compare(a,b) < 0)
 #define GBR_is_zero(a)			    (mp_rat_compare_zero(a) == 0)
 #ifdef USE_SMALL_INT_OPT
@@ -77,6 +86,12 @@ struct tab_lp {
 		impz_set(mp_rat_denom_ref(*a),             \
 		    isl_sioimath_bigarg_src(*b, &scratch));\
 	} while (0)
+#define GBR_sub_int(a, b, c)                               \
+	do {                                               \
+		isl_sioimath_scratchspace_t scratch;       \
+		mp_rat_sub_int(b,                          \
+		    isl_sioimath_bigarg_src(*c, &scratch), a);\
+	} while (0)
 #else /* USE_SMALL_INT_OPT */
 #define GBR_numref(a)		mp_rat_numer_ref(a)
 #define GBR_denref(a)		mp_rat_denom_ref(a)
@@ -84,6 +99,7 @@ struct tab_lp {
 #define GBR_ceil(a,b)		impz_cdiv_q(a,GBR_numref(b),GBR_denref(b))
 #define GBR_set_num_neg(a, b)	impz_neg(GBR_numref(*a), b)
 #define GBR_set_den(a, b)	impz_set(GBR_denref(*a), b)
+#define GBR_sub_int(a, b, c)	mp_rat_sub_int(b, c, a)
 #endif /* USE_SMALL_INT_OPT */
 #endif /* USE_IMATH_FOR_MP */
 
@@ -25,6 +25,53 @@ static void save_alpha(GBR_LP *lp, int first, int n, GBR_type *alpha)
 		GBR_lp_get_alpha(lp, first + i, &alpha[i]);
 }
 
+/* Given F_i(b_i) = "F", F_{i+1}(b_{i+1}) = "F_new" and
+ * the dual value "alpha", with floor(alpha) = "mu" < alpha,
+ * determine which of floor(alpha) and ceil(alpha) yields the smaller
+ * value of F_i(b_{i+1} + mu b_i), if this can be derived
+ * without solving any LP.
+ * Return 0 if floor(alpha) is known to yield a strictly smaller value,
+ * 1 if ceil(alpha) is known to yield a value that is not greater and
+ * -1 if nothing is known.
+ *
+ * The function f(mu) = F_i(b_{i+1} + mu b_i) attains its minimal value F_new
+ * at mu = alpha.  Since F_i is a seminorm, f is bounded by
+ *
+ *	max(F_new, |mu - alpha| F - F_new) <= f(mu) <= F_new + |mu - alpha| F
+ *
+ * Let d0 = alpha - floor(alpha) and d1 = ceil(alpha) - alpha = 1 - d0.
+ * The upper bound on f(floor(alpha)) is strictly smaller
+ * than the lower bound on f(ceil(alpha)) if 2 F_new < (d1 - d0) F,
+ * while the upper bound on f(ceil(alpha)) is not greater
+ * than the lower bound on f(floor(alpha)) if 2 F_new + (d1 - d0) F <= 0.
+ */
+static int known_mu(GBR_type F, GBR_type F_new, GBR_type alpha, isl_int mu)
+{
+	int known = -1;
+	GBR_type t, s;
+
+	GBR_init(t);
+	GBR_init(s);
+
+	GBR_sub_int(t, alpha, mu);
+	GBR_set_ui(s, 1);
+	GBR_sub(s, s, t);
+	GBR_sub(s, s, t);
+	GBR_mul(t, s, F);
+	GBR_add(s, F_new, F_new);
+	if (GBR_lt(s, t))
+		known = 0;
+	GBR_add(s, s, t);
+	GBR_set_ui(t, 0);
+	if (!GBR_lt(t, s))
+		known = 1;
+
+	GBR_clear(t);
+	GBR_clear(s);
+
+	return known;
+}
+
 /* Compute a reduced basis for the set represented by the tableau "tab".
  * tab->basis, which must be initialized by the calling function to an affine
  * unimodular basis, is updated to reflect the reduced basis.
@@ -42,11 +89,17 @@ static void save_alpha(GBR_LP *lp, int first, int n, GBR_type *alpha)
  *  for Integer Programming" of Cook el al. to compute a reduced basis.
  * We use \epsilon = 1/4.
  *
- * If ctx->opt->gbr_only_first is set, the user is only interested
+ * If "only_first" is set, the user is only interested
  * in the first direction.  In this case we stop the basis reduction when
  * the width in the first direction becomes smaller than 2.
+ *
+ * If alpha is not integral, then the widths obtained from rounding
+ * alpha down and up are only computed if known_mu cannot determine
+ * which of the two is smaller from the widths that have already
+ * been computed.
  */
-struct isl_tab *isl_tab_compute_reduced_basis(struct isl_tab *tab)
+struct isl_tab *isl_tab_compute_reduced_basis_only_first(struct isl_tab *tab,
+	int only_first)
 {
 	unsigned dim;
 	struct isl_ctx *ctx;
@@ -71,7 +124,6 @@ struct isl_tab *isl_tab_compute_reduced_basis(struct isl_tab *tab)
 	int fixed_saved = 0;
 	int mu_fixed[2];
 	int n_bounded;
-	int gbr_only_first;
 
 	if (!tab)
 		return NULL;
@@ -80,7 +132,6 @@ struct isl_tab *isl_tab_compute_reduced_basis(struct isl_tab *tab)
 		return tab;
 
 	ctx = tab->mat->ctx;
-	gbr_only_first = ctx->opt->gbr_only_first;
 	dim = tab->n_var;
 	B = tab->basis;
 	if (!B)
@@ -131,7 +182,7 @@ struct isl_tab *isl_tab_compute_reduced_basis(struct isl_tab *tab)
 	i = tab->n_zero;
 
 	GBR_lp_set_obj(lp, B->row[1+i]+1, dim);
-	ctx->stats->gbr_solved_lps++;
+	isl_ctx_count_gbr_lp(ctx);
 	if (GBR_lp_solve(lp) < 0)
 		goto error;
 	GBR_lp_get_obj_val(lp, &F[i]);
@@ -149,7 +200,7 @@ struct isl_tab *isl_tab_compute_reduced_basis(struct isl_tab *tab)
 	do {
 		if (i+1 == tab->n_zero) {
 			GBR_lp_set_obj(lp, B->row[1+i+1]+1, dim);
-			ctx->stats->gbr_solved_lps++;
+			isl_ctx_count_gbr_lp(ctx);
 			if (GBR_lp_solve(lp) < 0)
 				goto error;
 			GBR_lp_get_obj_val(lp, &F_new);
@@ -164,7 +215,7 @@ struct isl_tab *isl_tab_compute_reduced_basis(struct isl_tab *tab)
 		} else {
 			row = GBR_lp_add_row(lp, B->row[1+i]+1, dim);
 			GBR_lp_set_obj(lp, B->row[1+i+1]+1, dim);
-			ctx->stats->gbr_solved_lps++;
+			isl_ctx_count_gbr_lp(ctx);
 			if (GBR_lp_solve(lp) < 0)
 				goto error;
 			GBR_lp_get_obj_val(lp, &F_new);
@@ -186,15 +237,18 @@ struct isl_tab *isl_tab_compute_reduced_basis(struct isl_tab *tab)
 		if (isl_int_eq(mu[0], mu[1]))
 			isl_int_set(tmp, mu[0]);
 		else {
-			int j;
+			int j, known;
 
+			known = known_mu(F[i], F_new, alpha, mu[0]);
 			for (j = 0; j <= 1; ++j) {
+				if (known >= 0 && j != known)
+					continue;
 				isl_int_set(tmp, mu[j]);
 				isl_seq_combine(b_tmp->el,
 						ctx->one, B->row[1+i+1]+1,
 						tmp, B->row[1+i]+1, dim);
 				GBR_lp_set_obj(lp, b_tmp->el, dim);
-				ctx->stats->gbr_solved_lps++;
+				isl_ctx_count_gbr_lp(ctx);
 				if (GBR_lp_solve(lp) < 0)
 					goto error;
 				GBR_lp_get_obj_val(lp, &mu_F[j]);
@@ -203,7 +257,9 @@ struct isl_tab *isl_tab_compute_reduced_basis(struct isl_tab *tab)
 					save_alpha(lp, row-i, i, alpha_buffer[j]);
 			}
 
-			if (GBR_lt(mu_F[0], mu_F[1]))
+			if (known >= 0)
+				j = known;
+			else if (GBR_lt(mu_F[0], mu_F[1]))
 				j = 0;
 			else
 				j = 1;
@@ -245,7 +301,7 @@ struct isl_tab *isl_tab_compute_reduced_basis(struct isl_tab *tab)
 				--i;
 			} else {
 				GBR_set(F[tab->n_zero], F_new);
-				if (gbr_only_first && GBR_lt(F[tab->n_zero], two))
+				if (only_first && GBR_lt(F[tab->n_zero], two))
 					break;
 
 				if (fixed) {
@@ -305,6 +361,18 @@ error:
 	return tab;
 }
 
+/* Compute a reduced basis for the set represented by the tableau "tab",
+ * stopping early if the "gbr_only_first" option is set.
+ */
+struct isl_tab *isl_tab_compute_reduced_basis(struct isl_tab *tab)
+{
+	if (!tab)
+		return NULL;
+
+	return isl_tab_compute_reduced_basis_only_first(tab,
+					tab->mat->ctx->opt->gbr_only_first);
+}
+
 /* Compute an affine form of a reduced basis of the given basic
  * non-parametric set, which is assumed to be bounded and not
  * include any integer divisions.
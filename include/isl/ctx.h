@@ -70,6 +70,13 @@ extern "C" {
  */
 struct isl_stats {
 	long	gbr_solved_lps;
+	long	pivots;
+	long	degenerate_pivots;
+	long	subset_universe;
+	long	subset_plain;
+	long	subset_bounds;
+	long	subset_exact;
+	long	lp_double_starts;
 };
 enum isl_error {
 	isl_error_none = 0,
@@ -171,6 +178,12 @@ void isl_ctx_set_max_operations(isl_ctx *ctx, unsigned long max_operations);
 unsigned long isl_ctx_get_max_operations(isl_ctx *ctx);
 void isl_ctx_reset_operations(isl_ctx *ctx);
 
+const struct isl_stats *isl_ctx_get_stats(isl_ctx *ctx);
+void isl_ctx_reset_stats(isl_ctx *ctx);
+
+isl_stat isl_ctx_set_thread_safe(isl_ctx *ctx, int thread_safe);
+int isl_ctx_is_thread_safe(isl_ctx *ctx);
+
 #define ISL_ARG_CTX_DECL(prefix,st,args)				\
 st *isl_ctx_peek_ ## prefix(isl_ctx *ctx);
 
@@ -28,6 +28,10 @@ __isl_give isl_val *isl_set_min_val(__isl_keep isl_set *set,
 __isl_export
 __isl_give isl_val *isl_set_max_val(__isl_keep isl_set *set,
 	__isl_keep isl_aff *obj);
+__isl_give isl_val *isl_set_min_val_bounded(__isl_keep isl_set *set,
+	__isl_keep isl_aff *obj, int max_steps, int *exact);
+__isl_give isl_val *isl_set_max_val_bounded(__isl_keep isl_set *set,
+	__isl_keep isl_aff *obj, int max_steps, int *exact);
 __isl_give isl_multi_val *isl_union_set_min_multi_union_pw_aff(
 	__isl_keep isl_union_set *set, __isl_keep isl_multi_union_pw_aff *obj);
 
@@ -0,0 +1,39 @@
+#ifndef ISL_MAP_PIPELINE_H
+#define ISL_MAP_PIPELINE_H
+
+#include <isl/space.h>
+#include <isl/map_type.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+struct isl_map_pipeline;
+typedef struct isl_map_pipeline isl_map_pipeline;
+
+__isl_give isl_map_pipeline *isl_map_pipeline_from_map(
+	__isl_take isl_map *map);
+isl_ctx *isl_map_pipeline_get_ctx(__isl_keep isl_map_pipeline *pipeline);
+__isl_give isl_map_pipeline *isl_map_pipeline_copy(
+	__isl_keep isl_map_pipeline *pipeline);
+__isl_null isl_map_pipeline *isl_map_pipeline_free(
+	__isl_take isl_map_pipeline *pipeline);
+
+__isl_give isl_map_pipeline *isl_map_pipeline_apply_range(
+	__isl_take isl_map_pipeline *pipeline, __isl_take isl_map *map);
+__isl_give isl_map_pipeline *isl_map_pipeline_intersect_domain(
+	__isl_take isl_map_pipeline *pipeline, __isl_take isl_set *set);
+__isl_give isl_map_pipeline *isl_map_pipeline_project_out(
+	__isl_take isl_map_pipeline *pipeline,
+	enum isl_dim_type type, unsigned first, unsigned n);
+__isl_give isl_map_pipeline *isl_map_pipeline_coalesce(
+	__isl_take isl_map_pipeline *pipeline);
+
+__isl_give isl_map *isl_map_pipeline_evaluate(
+	__isl_take isl_map_pipeline *pipeline);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif
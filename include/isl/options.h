@@ -35,6 +35,18 @@ int isl_options_get_on_error(isl_ctx *ctx);
 isl_stat isl_options_set_gbr_only_first(isl_ctx *ctx, int val);
 int isl_options_get_gbr_only_first(isl_ctx *ctx);
 
+#define			ISL_PIVOT_BLAND		0
+#define			ISL_PIVOT_STEEPEST_EDGE	1
+#define			ISL_PIVOT_DEVEX		2
+isl_stat isl_options_set_pivot_rule(isl_ctx *ctx, int val);
+int isl_options_get_pivot_rule(isl_ctx *ctx);
+
+isl_stat isl_options_set_lp_double_start(isl_ctx *ctx, int val);
+int isl_options_get_lp_double_start(isl_ctx *ctx);
+
+isl_stat isl_options_set_lp_presolve(isl_ctx *ctx, int val);
+int isl_options_get_lp_presolve(isl_ctx *ctx);
+
 #define		ISL_SCHEDULE_ALGORITHM_ISL		0
 #define		ISL_SCHEDULE_ALGORITHM_FEAUTRIER	1
 isl_stat isl_options_set_schedule_algorithm(isl_ctx *ctx, int val);
@@ -42,9 +54,15 @@ int isl_options_get_schedule_algorithm(isl_ctx *ctx);
 
 isl_stat isl_options_set_pip_symmetry(isl_ctx *ctx, int val);
 int isl_options_get_pip_symmetry(isl_ctx *ctx);
+isl_stat isl_options_set_pip_parallel_depth(isl_ctx *ctx, int val);
+int isl_options_get_pip_parallel_depth(isl_ctx *ctx);
 
 isl_stat isl_options_set_coalesce_bounded_wrapping(isl_ctx *ctx, int val);
 int isl_options_get_coalesce_bounded_wrapping(isl_ctx *ctx);
+isl_stat isl_options_set_coalesce_cache_size(isl_ctx *ctx, int val);
+int isl_options_get_coalesce_cache_size(isl_ctx *ctx);
+isl_stat isl_options_set_subtract_coalesce(isl_ctx *ctx, int val);
+int isl_options_get_subtract_coalesce(isl_ctx *ctx);
 
 #if defined(__cplusplus)
 }
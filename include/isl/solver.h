@@ -0,0 +1,37 @@
+#ifndef ISL_SOLVER_H
+#define ISL_SOLVER_H
+
+#include <isl/aff_type.h>
+#include <isl/constraint.h>
+#include <isl/set_type.h>
+#include <isl/val.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+struct isl_solver;
+typedef struct isl_solver isl_solver;
+
+__isl_give isl_solver *isl_solver_from_basic_set(
+	__isl_take isl_basic_set *bset);
+isl_ctx *isl_solver_get_ctx(__isl_keep isl_solver *solver);
+__isl_null isl_solver *isl_solver_free(__isl_take isl_solver *solver);
+
+__isl_give isl_solver *isl_solver_push(__isl_take isl_solver *solver);
+__isl_give isl_solver *isl_solver_pop(__isl_take isl_solver *solver);
+__isl_give isl_solver *isl_solver_add_constraint(
+	__isl_take isl_solver *solver, __isl_take isl_constraint *constraint);
+
+isl_bool isl_solver_is_empty(__isl_keep isl_solver *solver);
+isl_bool isl_solver_is_rational_empty(__isl_keep isl_solver *solver);
+__isl_give isl_val *isl_solver_min_val(__isl_keep isl_solver *solver,
+	__isl_keep isl_aff *obj);
+__isl_give isl_val *isl_solver_max_val(__isl_keep isl_solver *solver,
+	__isl_keep isl_aff *obj);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif
@@ -77,6 +77,7 @@ struct isl_blk isl_blk_alloc(struct isl_ctx *ctx, size_t n)
 	struct isl_blk block;
 
 	block = isl_blk_empty();
+	isl_ctx_lock(ctx);
 	if (n && ctx->n_cached) {
 		int best = 0;
 		for (i = 1; ctx->cache[best].size != n && i < ctx->n_cached; ++i) {
@@ -100,6 +101,7 @@ struct isl_blk isl_blk_alloc(struct isl_ctx *ctx, size_t n)
 			ctx->n_miss = 0;
 		}
 	}
+	isl_ctx_unlock(ctx);
 
 	return extend(ctx, block, n);
 }
@@ -118,10 +120,15 @@ void isl_blk_free(struct isl_ctx *ctx, struct isl_blk block)
 	if (isl_blk_is_empty(block) || isl_blk_is_error(block))
 		return;
 
-	if (ctx->n_cached < ISL_BLK_CACHE_SIZE)
+	isl_ctx_lock(ctx);
+	if (ctx->n_cached < ISL_BLK_CACHE_SIZE) {
 		ctx->cache[ctx->n_cached++] = block;
-	else
-		isl_blk_free_force(ctx, block);
+		isl_ctx_unlock(ctx);
+		return;
+	}
+	isl_ctx_unlock(ctx);
+
+	isl_blk_free_force(ctx, block);
 }
 
 void isl_blk_clear_cache(struct isl_ctx *ctx)
@@ -173,6 +173,14 @@ static int all(int *con, unsigned len, int status)
  * the other basic map.  The number of elements in the "eq" array
  * is twice the number of equalities in the "bmap", corresponding
  * to the two inequalities that make up each equality.
+ *
+ * "box" holds bounds on the variables of "bmap", if they have been
+ * computed, derived from those equalities and non-redundant inequalities
+ * of "bmap" that only involve a single variable and
+ * with a unit coefficient.
+ * These bounds are only computed for basic maps without integer divisions
+ * and are used by coalesce_range to skip pairs of basic maps
+ * that are obviously separated.
  */
 struct isl_coalesce_info {
 	isl_basic_map *bmap;
@@ -182,6 +190,7 @@ struct isl_coalesce_info {
 	int simplify;
 	int *eq;
 	int *ineq;
+	struct isl_map_box box;
 };
 
 /* Are all non-redundant constraints of the basic map represented by "info"
@@ -247,11 +256,21 @@ static void clear_coalesce_info(int n, struct isl_coalesce_info *info)
 	for (i = 0; i < n; ++i) {
 		isl_basic_map_free(info[i].bmap);
 		isl_tab_free(info[i].tab);
+		isl_map_box_clear(&info[i].box);
 	}
 
 	free(info);
 }
 
+/* Discard the bounds on the variables of the basic map represented
+ * by "info", if any.
+ * They need to be recomputed if the basic map changes.
+ */
+static void clear_box(struct isl_coalesce_info *info)
+{
+	isl_map_box_clear(&info->box);
+}
+
 /* Drop the basic map represented by "info".
  * That is, clear the memory associated to the entry and
  * mark it as having been removed.
@@ -261,6 +280,7 @@ static void drop(struct isl_coalesce_info *info)
 	info->bmap = isl_basic_map_free(info->bmap);
 	isl_tab_free(info->tab);
 	info->tab = NULL;
+	clear_box(info);
 	info->removed = 1;
 }
 
@@ -817,6 +837,7 @@ static int is_affected(__isl_keep isl_basic_map *bmap, int ineq, int *affected,
 static __isl_give isl_vec *try_tightening(struct isl_coalesce_info *info,
 	int ineq, __isl_take isl_vec *v)
 {
+	isl_int local, *gcd;
 	isl_ctx *ctx;
 	int r;
 
@@ -824,17 +845,21 @@ static __isl_give isl_vec *try_tightening(struct isl_coalesce_info *info,
 		return NULL;
 
 	ctx = isl_vec_get_ctx(v);
-	isl_seq_gcd(v->el + 1, v->size - 1, &ctx->normalize_gcd);
-	if (isl_int_is_zero(ctx->normalize_gcd) ||
-	    isl_int_is_one(ctx->normalize_gcd)) {
+	gcd = isl_ctx_get_normalize_gcd(ctx, &local);
+	isl_seq_gcd(v->el + 1, v->size - 1, gcd);
+	if (isl_int_is_zero(*gcd) || isl_int_is_one(*gcd)) {
+		isl_ctx_release_normalize_gcd(ctx, gcd);
 		return v;
 	}
 
 	v = isl_vec_cow(v);
-	if (!v)
+	if (!v) {
+		isl_ctx_release_normalize_gcd(ctx, gcd);
 		return NULL;
+	}
 
-	isl_int_fdiv_r(v->el[0], v->el[0], ctx->normalize_gcd);
+	isl_int_fdiv_r(v->el[0], v->el[0], *gcd);
+	isl_ctx_release_normalize_gcd(ctx, gcd);
 	if (isl_int_is_zero(v->el[0]))
 		return v;
 
@@ -3008,6 +3033,95 @@ static int isl_max(int a, int b)
 	return a > b ? a : b;
 }
 
+/* Compute bounds on the variables of the basic map represented by "info",
+ * if they have not been computed already.
+ * The basic map is assumed not to have any integer divisions.
+ *
+ * Only non-redundant inequality constraints are taken into account
+ * such that any bound that is used to separate this basic map
+ * from another basic map is also considered by coalesce_local_pair.
+ * For the same reason, only constraints with a unit coefficient
+ * are taken into account, such that the bounds are not rounded.
+ */
+static isl_stat coalesce_info_set_box(struct isl_coalesce_info *info)
+{
+	int k;
+	unsigned total;
+	isl_basic_map *bmap = info->bmap;
+	struct isl_map_box *box = &info->box;
+
+	if (box->bound)
+		return isl_stat_ok;
+
+	total = isl_basic_map_total_dim(bmap);
+	if (isl_map_box_alloc(box, bmap->ctx, total) < 0) {
+		clear_box(info);
+		return isl_stat_error;
+	}
+
+	for (k = 0; k < bmap->n_eq; ++k)
+		isl_map_box_add_constraint(box, bmap->eq[k], 1, total, total, 1);
+	for (k = 0; k < bmap->n_ineq; ++k) {
+		if (isl_tab_is_redundant(info->tab, bmap->n_eq + k))
+			continue;
+		isl_map_box_add_constraint(box, bmap->ineq[k], 0, total, total,
+						1);
+	}
+
+	return isl_stat_ok;
+}
+
+/* Is there any variable with a lower bound in "info1" that exceeds
+ * its upper bound in "info2" by at least two?
+ */
+static int box_exceeds(struct isl_coalesce_info *info1,
+	struct isl_coalesce_info *info2)
+{
+	int k;
+	int exceeds = 0;
+	struct isl_map_box *box1 = &info1->box, *box2 = &info2->box;
+	int n = box1->bound->size / 2;
+	isl_int d;
+
+	isl_int_init(d);
+	for (k = 0; !exceeds && k < n; ++k) {
+		if (!box1->bounded[2 * k] || !box2->bounded[2 * k + 1])
+			continue;
+		isl_int_sub(d, box1->bound->el[2 * k],
+				box2->bound->el[2 * k + 1]);
+		exceeds = isl_int_cmp_si(d, 2) >= 0;
+	}
+	isl_int_clear(d);
+
+	return exceeds;
+}
+
+/* Are the basic maps represented by "info1" and "info2" obviously
+ * separated, such that they cannot possibly be coalesced?
+ *
+ * We only perform this test if neither basic map has any integer divisions.
+ * In this case, coalesce_pair reduces to coalesce_local_pair,
+ * which gives up as soon as it finds a constraint of one basic map
+ * that is a separating constraint with respect to the other.
+ * In particular, if some variable has a lower bound of the form
+ * x >= l in one basic map and an upper bound of the form x <= u
+ * in the other, with u + 1 < l, then x - l >= 0 is such
+ * a separating constraint.  Checking the bounding boxes
+ * is much cheaper than setting up the tableau operations
+ * of coalesce_local_pair.
+ */
+static int coalesce_info_separated(struct isl_coalesce_info *info1,
+	struct isl_coalesce_info *info2)
+{
+	if (info1->bmap->n_div != 0 || info2->bmap->n_div != 0)
+		return 0;
+	if (coalesce_info_set_box(info1) < 0 ||
+	    coalesce_info_set_box(info2) < 0)
+		return -1;
+
+	return box_exceeds(info1, info2) || box_exceeds(info2, info1);
+}
+
 /* Pairwise coalesce the basic maps in the range [start1, end1[ of "info"
  * with those in the range [start2, end2[, skipping basic maps
  * that have been removed (either before or within this function).
@@ -3021,6 +3135,11 @@ static int isl_max(int a, int b)
  * If the two basic maps got fused, then we recheck the fused basic map
  * against the previously considered basic maps, starting at i + 1
  * (even if start2 is greater than i + 1).
+ *
+ * Pairs of basic maps that are obviously separated are skipped
+ * without calling coalesce_pair.  Since the bounding boxes
+ * used in this test are derived from the basic maps, they are discarded
+ * whenever a basic map gets modified.
  */
 static int coalesce_range(isl_ctx *ctx, struct isl_coalesce_info *info,
 	int start1, int end1, int start2, int end2)
@@ -3031,6 +3150,7 @@ static int coalesce_range(isl_ctx *ctx, struct isl_coalesce_info *info,
 		if (info[i].removed)
 			continue;
 		for (j = isl_max(i + 1, start2); j < end2; ++j) {
+			int separated;
 			enum isl_change changed;
 
 			if (info[j].removed)
@@ -3039,7 +3159,16 @@ static int coalesce_range(isl_ctx *ctx, struct isl_coalesce_info *info,
 				isl_die(ctx, isl_error_internal,
 					"basic map unexpectedly removed",
 					return -1);
+			separated = coalesce_info_separated(&info[i], &info[j]);
+			if (separated < 0)
+				return -1;
+			if (separated)
+				continue;
 			changed = coalesce_pair(i, j, info);
+			if (changed != isl_change_none) {
+				clear_box(&info[i]);
+				clear_box(&info[j]);
+			}
 			switch (changed) {
 			case isl_change_error:
 				return -1;
@@ -3147,7 +3276,7 @@ static __isl_give isl_map *update_basic_maps(__isl_take isl_map *map,
  * For each basic map, we also compute the hash of the apparent affine hull
  * for use in coalesce.
  */
-struct isl_map *isl_map_coalesce(struct isl_map *map)
+static struct isl_map *map_coalesce(struct isl_map *map)
 {
 	int i;
 	unsigned n;
@@ -3213,6 +3342,174 @@ error:
 	return NULL;
 }
 
+/* An element of the coalesce cache.
+ * "map" is the input of an earlier call to isl_map_coalesce,
+ * "hash" is its hash value and "res" is the corresponding result.
+ * "bounded_wrapping" is the value of the coalesce_bounded_wrapping option
+ * at the time of the call.
+ */
+struct isl_coalesce_cache_entry {
+	uint32_t hash;
+	int bounded_wrapping;
+	isl_map *map;
+	isl_map *res;
+};
+
+/* The coalesce cache of an isl_ctx.
+ * The "n" elements of "entry" are ordered from most recently used
+ * to least recently used.  "size" is the number of allocated elements.
+ */
+struct isl_coalesce_cache {
+	int n;
+	int size;
+	struct isl_coalesce_cache_entry *entry;
+};
+
+/* Remove the least recently used element from "cache".
+ */
+static void coalesce_cache_drop_last(struct isl_coalesce_cache *cache)
+{
+	cache->n--;
+	isl_map_free(cache->entry[cache->n].map);
+	isl_map_free(cache->entry[cache->n].res);
+}
+
+/* Free the coalesce cache of "ctx", if any.
+ */
+void isl_coalesce_cache_clear(isl_ctx *ctx)
+{
+	struct isl_coalesce_cache *cache;
+
+	cache = ctx->coalesce_cache;
+	if (!cache)
+		return;
+	ctx->coalesce_cache = NULL;
+	while (cache->n > 0)
+		coalesce_cache_drop_last(cache);
+	free(cache->entry);
+	free(cache);
+}
+
+/* Return the coalesce cache of "ctx", making sure it has room
+ * for "size" elements and no more than "size" elements.
+ * The cache is created on first use.
+ */
+static struct isl_coalesce_cache *get_coalesce_cache(isl_ctx *ctx, int size)
+{
+	struct isl_coalesce_cache *cache;
+	struct isl_coalesce_cache_entry *entry;
+
+	cache = ctx->coalesce_cache;
+	if (!cache) {
+		cache = isl_calloc_type(ctx, struct isl_coalesce_cache);
+		if (!cache)
+			return NULL;
+		ctx->coalesce_cache = cache;
+	}
+	if (cache->size == size)
+		return cache;
+
+	while (cache->n > size)
+		coalesce_cache_drop_last(cache);
+	entry = isl_realloc_array(ctx, cache->entry,
+				struct isl_coalesce_cache_entry, size);
+	if (!entry)
+		return NULL;
+	cache->entry = entry;
+	cache->size = size;
+
+	return cache;
+}
+
+/* Coalesce "map", keeping track of the result in the coalesce cache
+ * of its context, which is assumed to be able to hold "size" elements.
+ *
+ * If the cache contains an input that is obviously equal to "map",
+ * then return the corresponding result and mark the element
+ * as most recently used.
+ * Otherwise, coalesce "map" and store the input and the result
+ * as the most recently used element, evicting the least recently used
+ * element if the cache is full.
+ */
+static __isl_give isl_map *coalesce_cached(__isl_take isl_map *map, int size)
+{
+	int i;
+	int bounded_wrapping;
+	uint32_t hash;
+	isl_ctx *ctx;
+	struct isl_coalesce_cache *cache;
+	struct isl_coalesce_cache_entry entry;
+
+	ctx = isl_map_get_ctx(map);
+	cache = get_coalesce_cache(ctx, size);
+	if (!cache)
+		return isl_map_free(map);
+
+	bounded_wrapping = isl_options_get_coalesce_bounded_wrapping(ctx);
+	hash = isl_map_get_hash(map);
+	for (i = 0; i < cache->n; ++i) {
+		isl_bool equal;
+
+		if (cache->entry[i].hash != hash)
+			continue;
+		if (cache->entry[i].bounded_wrapping != bounded_wrapping)
+			continue;
+		equal = isl_map_plain_is_equal(cache->entry[i].map, map);
+		if (equal < 0)
+			return isl_map_free(map);
+		if (equal)
+			break;
+	}
+
+	if (i < cache->n) {
+		entry = cache->entry[i];
+		memmove(cache->entry + 1, cache->entry, i * sizeof(entry));
+		cache->entry[0] = entry;
+		isl_map_free(map);
+		return isl_map_copy(entry.res);
+	}
+
+	entry.hash = hash;
+	entry.bounded_wrapping = bounded_wrapping;
+	entry.map = isl_map_copy(map);
+	map = map_coalesce(map);
+	if (!map) {
+		isl_map_free(entry.map);
+		return NULL;
+	}
+	entry.res = isl_map_copy(map);
+
+	if (cache->n == cache->size)
+		coalesce_cache_drop_last(cache);
+	memmove(cache->entry + 1, cache->entry, cache->n * sizeof(entry));
+	cache->entry[0] = entry;
+	cache->n++;
+
+	return map;
+}
+
+/* Coalesce "map", reusing the result of an earlier call
+ * on an obviously equal input if the coalesce cache is enabled.
+ * The cache is not used in thread-safe mode since it is shared
+ * by all users of the context.
+ * Maps with at most one basic map are not worth caching.
+ */
+struct isl_map *isl_map_coalesce(struct isl_map *map)
+{
+	isl_ctx *ctx;
+	int size;
+
+	if (!map)
+		return NULL;
+
+	ctx = isl_map_get_ctx(map);
+	size = isl_options_get_coalesce_cache_size(ctx);
+	if (size <= 0 || ctx->thread_safe || map->n <= 1)
+		return map_coalesce(map);
+
+	return coalesce_cached(map, size);
+}
+
 /* For each pair of basic sets in the set, check if the union of the two
  * can be represented by a single basic set.
  * If so, replace the pair by the single basic set and start over.
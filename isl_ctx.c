@@ -14,6 +14,17 @@
 #define __isl_calloc(type,size)		((type *)calloc(1, size))
 #define __isl_calloc_type(type)		__isl_calloc(type,sizeof(type))
 
+#ifdef ISL_HAVE_ATOMIC
+/* The last identifier handed out to a thread and
+ * the identifier of the current thread, or zero if it has not been
+ * assigned yet.
+ * Identifiers are never reused, such that the error state
+ * of a thread cannot be picked up by a later thread.
+ */
+static unsigned long last_thread_id;
+static __thread unsigned long thread_id;
+#endif
+
 /* Return the negation of "b", where the negation of isl_bool_error
  * is isl_bool_error again.
  */
@@ -48,6 +59,19 @@ int isl_ctx_next_operation(isl_ctx *ctx)
 		isl_ctx_set_error(ctx, isl_error_abort);
 		return -1;
 	}
+#ifdef ISL_HAVE_ATOMIC
+	if (ctx->thread_safe) {
+		unsigned long operations;
+
+		operations = __atomic_add_fetch(&ctx->operations, 1,
+						__ATOMIC_RELAXED);
+		if (ctx->max_operations && operations > ctx->max_operations)
+			isl_die(ctx, isl_error_quota,
+				"maximal number of operations exceeded",
+				return -1);
+		return 0;
+	}
+#endif
 	if (ctx->max_operations && ctx->operations >= ctx->max_operations)
 		isl_die(ctx, isl_error_quota,
 			"maximal number of operations exceeded", return -1);
@@ -55,6 +79,162 @@ int isl_ctx_next_operation(isl_ctx *ctx)
 	return 0;
 }
 
+/* Increment the statistics counter "counter" of "ctx".
+ */
+static void count(isl_ctx *ctx, long *counter)
+{
+#ifdef ISL_HAVE_ATOMIC
+	if (ctx->thread_safe) {
+		__atomic_add_fetch(counter, 1, __ATOMIC_RELAXED);
+		return;
+	}
+#endif
+	(*counter)++;
+}
+
+/* Keep track of the fact that a pivot has been performed
+ * in a tableau allocated in "ctx".
+ * "degenerate" is set if the pivot does not change the sample value.
+ */
+void isl_ctx_count_pivot(isl_ctx *ctx, int degenerate)
+{
+	count(ctx, &ctx->stats->pivots);
+	if (degenerate)
+		count(ctx, &ctx->stats->degenerate_pivots);
+}
+
+/* Keep track of the fact that a tableau allocated in "ctx"
+ * was moved to a basis computed in double precision.
+ */
+void isl_ctx_count_double_start(isl_ctx *ctx)
+{
+	count(ctx, &ctx->stats->lp_double_starts);
+}
+
+/* Keep track of the fact that an LP has been solved
+ * during generalized basis reduction in "ctx".
+ */
+void isl_ctx_count_gbr_lp(isl_ctx *ctx)
+{
+	count(ctx, &ctx->stats->gbr_solved_lps);
+}
+
+/* Keep track of the fact that a subset query in "ctx"
+ * was decided by the test identified by "decision".
+ */
+void isl_ctx_count_subset(isl_ctx *ctx, enum isl_subset_decision decision)
+{
+	switch (decision) {
+	case isl_subset_universe:
+		count(ctx, &ctx->stats->subset_universe);
+		break;
+	case isl_subset_plain:
+		count(ctx, &ctx->stats->subset_plain);
+		break;
+	case isl_subset_bounds:
+		count(ctx, &ctx->stats->subset_bounds);
+		break;
+	case isl_subset_exact:
+		count(ctx, &ctx->stats->subset_exact);
+		break;
+	}
+}
+
+/* Acquire the lock of "ctx" if "ctx" is in thread-safe mode.
+ * The lock is only held for short periods of time,
+ * so a simple spin lock is used.
+ */
+void isl_ctx_lock(isl_ctx *ctx)
+{
+#ifdef ISL_HAVE_ATOMIC
+	if (!ctx->thread_safe)
+		return;
+	while (__atomic_exchange_n(&ctx->lock, 1, __ATOMIC_ACQUIRE))
+		while (__atomic_load_n(&ctx->lock, __ATOMIC_RELAXED))
+			;
+#endif
+}
+
+/* Release the lock acquired by isl_ctx_lock.
+ */
+void isl_ctx_unlock(isl_ctx *ctx)
+{
+#ifdef ISL_HAVE_ATOMIC
+	if (ctx->thread_safe)
+		__atomic_store_n(&ctx->lock, 0, __ATOMIC_RELEASE);
+#endif
+}
+
+/* Increment the reference count "ref" of an object allocated in "ctx"
+ * and return the new value.
+ * In thread-safe mode, the increment is performed atomically.
+ */
+int isl_ctx_inc_ref(isl_ctx *ctx, int *ref)
+{
+#ifdef ISL_HAVE_ATOMIC
+	if (ctx->thread_safe)
+		return __atomic_add_fetch(ref, 1, __ATOMIC_RELAXED);
+#endif
+	return ++*ref;
+}
+
+/* Decrement the reference count "ref" of an object allocated in "ctx"
+ * and return the new value.
+ * In thread-safe mode, the decrement is performed atomically.
+ * If the result is zero, then the caller is the only remaining user
+ * of the object, so any changes made by other threads before
+ * they dropped their references need to be visible.
+ */
+int isl_ctx_dec_ref(isl_ctx *ctx, int *ref)
+{
+#ifdef ISL_HAVE_ATOMIC
+	if (ctx->thread_safe)
+		return __atomic_sub_fetch(ref, 1, __ATOMIC_ACQ_REL);
+#endif
+	return --*ref;
+}
+
+/* Return the current value of the reference count "ref"
+ * of an object allocated in "ctx".
+ * In thread-safe mode, the value is read atomically such that
+ * any changes made by other threads before they dropped
+ * their references are visible if the caller turns out
+ * to be the only remaining user of the object.
+ */
+int isl_ctx_get_ref(isl_ctx *ctx, int *ref)
+{
+#ifdef ISL_HAVE_ATOMIC
+	if (ctx->thread_safe)
+		return __atomic_load_n(ref, __ATOMIC_ACQUIRE);
+#endif
+	return *ref;
+}
+
+/* Return a scratch value for computing a gcd in "ctx".
+ * Outside of thread-safe mode, the value kept in "ctx" is reused
+ * to avoid allocating and freeing memory on every call.
+ * In thread-safe mode, "local" is initialized and returned instead.
+ * The result needs to be released using isl_ctx_release_normalize_gcd.
+ */
+isl_int *isl_ctx_get_normalize_gcd(isl_ctx *ctx, isl_int *local)
+{
+#ifdef ISL_HAVE_ATOMIC
+	if (ctx->thread_safe) {
+		isl_int_init(*local);
+		return local;
+	}
+#endif
+	return &ctx->normalize_gcd;
+}
+
+/* Release the scratch value "gcd" obtained from isl_ctx_get_normalize_gcd.
+ */
+void isl_ctx_release_normalize_gcd(isl_ctx *ctx, isl_int *gcd)
+{
+	if (gcd != &ctx->normalize_gcd)
+		isl_int_clear(*gcd);
+}
+
 /* Call malloc and complain if it fails.
  * If ctx is NULL, then return NULL.
  */
@@ -227,13 +407,13 @@ struct isl_ctx *isl_ctx_alloc()
 
 void isl_ctx_ref(struct isl_ctx *ctx)
 {
-	ctx->ref++;
+	isl_ctx_inc_ref(ctx, &ctx->ref);
 }
 
 void isl_ctx_deref(struct isl_ctx *ctx)
 {
-	isl_assert(ctx, ctx->ref > 0, return);
-	ctx->ref--;
+	isl_assert(ctx, isl_ctx_get_ref(ctx, &ctx->ref) > 0, return);
+	isl_ctx_dec_ref(ctx, &ctx->ref);
 }
 
 /* Print statistics on usage.
@@ -241,12 +421,26 @@ void isl_ctx_deref(struct isl_ctx *ctx)
 static void print_stats(isl_ctx *ctx)
 {
 	fprintf(stderr, "operations: %lu\n", ctx->operations);
+	fprintf(stderr, "pivots: %ld\n", ctx->stats->pivots);
+	fprintf(stderr, "degenerate pivots: %ld\n",
+		ctx->stats->degenerate_pivots);
+	fprintf(stderr, "subset queries decided by universe test: %ld\n",
+		ctx->stats->subset_universe);
+	fprintf(stderr, "subset queries decided by plain tests: %ld\n",
+		ctx->stats->subset_plain);
+	fprintf(stderr, "subset queries decided by bounds: %ld\n",
+		ctx->stats->subset_bounds);
+	fprintf(stderr, "subset queries decided by exact test: %ld\n",
+		ctx->stats->subset_exact);
+	fprintf(stderr, "LPs started from a double precision basis: %ld\n",
+		ctx->stats->lp_double_starts);
 }
 
 void isl_ctx_free(struct isl_ctx *ctx)
 {
 	if (!ctx)
 		return;
+	isl_coalesce_cache_clear(ctx);
 	if (ctx->ref != 0)
 		isl_die(ctx, isl_error_invalid,
 			"isl_ctx freed, but some objects still reference it",
@@ -262,6 +456,7 @@ void isl_ctx_free(struct isl_ctx *ctx)
 	isl_int_clear(ctx->two);
 	isl_int_clear(ctx->negone);
 	isl_int_clear(ctx->normalize_gcd);
+	free(ctx->thread_error);
 	isl_args_free(ctx->user_args, ctx->user_opt);
 	if (ctx->opt_allocated)
 		isl_options_free(ctx->opt);
@@ -276,20 +471,139 @@ struct isl_options *isl_ctx_options(isl_ctx *ctx)
 	return ctx->opt;
 }
 
+#ifdef ISL_HAVE_ATOMIC
+/* Return the identifier of the current thread.
+ */
+static unsigned long current_thread_id(void)
+{
+	if (!thread_id)
+		thread_id = __atomic_add_fetch(&last_thread_id, 1,
+						__ATOMIC_RELAXED);
+	return thread_id;
+}
+
+/* Return the position of the error state of the thread
+ * with identifier "id" in ctx->thread_error or -1 if there is none.
+ * The lock of "ctx" is assumed to be held.
+ */
+static int find_thread_error(isl_ctx *ctx, unsigned long id)
+{
+	int i;
+
+	for (i = 0; i < ctx->n_thread_error; ++i)
+		if (ctx->thread_error[i].thread == id)
+			return i;
+	return -1;
+}
+
+/* Record "error" as the error state of the current thread in "ctx".
+ * A thread without error state is treated as having isl_error_none
+ * as error state, so no entry is kept for such threads.
+ *
+ * isl_handle_error cannot be used to report allocation failures here
+ * since it calls this function.  If no room can be allocated
+ * for the error state of the current thread, then the error
+ * is only recorded in ctx->error.
+ */
+static void set_thread_error(isl_ctx *ctx, enum isl_error error)
+{
+	int pos;
+	struct isl_thread_error *te;
+
+	isl_ctx_lock(ctx);
+	pos = find_thread_error(ctx, current_thread_id());
+	if (error == isl_error_none) {
+		if (pos >= 0)
+			ctx->thread_error[pos] =
+				ctx->thread_error[--ctx->n_thread_error];
+	} else if (pos >= 0) {
+		ctx->thread_error[pos].error = error;
+	} else {
+		if (ctx->n_thread_error >= ctx->size_thread_error) {
+			int size = 2 * ctx->size_thread_error + 1;
+			te = realloc(ctx->thread_error, size * sizeof(*te));
+			if (te) {
+				ctx->thread_error = te;
+				ctx->size_thread_error = size;
+			}
+		}
+		if (ctx->n_thread_error < ctx->size_thread_error) {
+			te = &ctx->thread_error[ctx->n_thread_error++];
+			te->thread = current_thread_id();
+			te->error = error;
+		}
+	}
+	isl_ctx_unlock(ctx);
+}
+#endif
+
+/* Return the last error that occurred in "ctx".
+ * In thread-safe mode, only errors that occurred in the current thread
+ * are taken into account.
+ */
 enum isl_error isl_ctx_last_error(isl_ctx *ctx)
 {
+#ifdef ISL_HAVE_ATOMIC
+	if (ctx->thread_safe) {
+		int pos;
+		enum isl_error error = isl_error_none;
+
+		isl_ctx_lock(ctx);
+		pos = find_thread_error(ctx, current_thread_id());
+		if (pos >= 0)
+			error = ctx->thread_error[pos].error;
+		isl_ctx_unlock(ctx);
+		return error;
+	}
+#endif
 	return ctx->error;
 }
 
 void isl_ctx_reset_error(isl_ctx *ctx)
 {
-	ctx->error = isl_error_none;
+	isl_ctx_set_error(ctx, isl_error_none);
 }
 
+/* Record "error" as the last error that occurred in "ctx".
+ * In thread-safe mode, the error is recorded for the current thread.
+ */
 void isl_ctx_set_error(isl_ctx *ctx, enum isl_error error)
 {
-	if (ctx)
-		ctx->error = error;
+	if (!ctx)
+		return;
+#ifdef ISL_HAVE_ATOMIC
+	if (ctx->thread_safe) {
+		set_thread_error(ctx, error);
+		__atomic_store_n(&ctx->error, error, __ATOMIC_RELAXED);
+		return;
+	}
+#endif
+	ctx->error = error;
+}
+
+/* Enable or disable thread-safe mode on "ctx".
+ * The mode should only be changed while "ctx" is used
+ * by a single thread.
+ */
+isl_stat isl_ctx_set_thread_safe(isl_ctx *ctx, int thread_safe)
+{
+	if (!ctx)
+		return isl_stat_error;
+#ifndef ISL_HAVE_ATOMIC
+	if (thread_safe)
+		isl_die(ctx, isl_error_unsupported,
+			"thread-safe mode not supported on this platform",
+			return isl_stat_error);
+#endif
+	ctx->thread_safe = !!thread_safe;
+	return isl_stat_ok;
+}
+
+/* Is "ctx" in thread-safe mode?
+ */
+int isl_ctx_is_thread_safe(isl_ctx *ctx)
+{
+	return ctx ? ctx->thread_safe : -1;
 }
 
 void isl_ctx_abort(isl_ctx *ctx)
@@ -340,3 +654,26 @@ void isl_ctx_reset_operations(isl_ctx *ctx)
 		return;
 	ctx->operations = 0;
 }
+
+/* Return the statistics gathered by "ctx".
+ */
+const struct isl_stats *isl_ctx_get_stats(isl_ctx *ctx)
+{
+	return ctx ? ctx->stats : NULL;
+}
+
+/* Reset the statistics gathered by "ctx".
+ */
+void isl_ctx_reset_stats(isl_ctx *ctx)
+{
+	if (!ctx)
+		return;
+	ctx->stats->gbr_solved_lps = 0;
+	ctx->stats->pivots = 0;
+	ctx->stats->degenerate_pivots = 0;
+	ctx->stats->subset_universe = 0;
+	ctx->stats->subset_plain = 0;
+	ctx->stats->subset_bounds = 0;
+	ctx->stats->subset_exact = 0;
+	ctx->stats->lp_double_starts = 0;
+}
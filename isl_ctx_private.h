@@ -1,6 +1,30 @@
 #include <isl/ctx.h>
 #include <isl_blk.h>
 
+/* Thread-safe mode relies on the compiler's atomic builtins.
+ */
+#if defined(__GNUC__) && defined(__ATOMIC_ACQUIRE)
+#define ISL_HAVE_ATOMIC
+#endif
+
+/* The error state "error" of the thread with identifier "thread".
+ */
+struct isl_thread_error {
+	unsigned long		thread;
+	enum isl_error		error;
+};
+
+/* If "thread_safe" is set, then the context may be used
+ * from several threads at the same time.
+ * "lock" is then used to protect the block cache and "id_table", while
+ * reference counts of contexts, identifiers and spaces, as well as
+ * "operations" and the counters in "stats", are updated atomically.
+ * The error state is then kept per thread in the "n_thread_error"
+ * elements of "thread_error", with room for "size_thread_error" elements,
+ * and "error" only records the last error that occurred in any thread.
+ * "normalize_gcd" is a scratch value that is only used
+ * outside of thread-safe mode.
+ */
 struct isl_ctx {
 	int			ref;
 
@@ -29,6 +53,45 @@ struct isl_ctx {
 
 	unsigned long		operations;
 	unsigned long		max_operations;
+
+	int			thread_safe;
+	int			lock;
+
+	int			n_thread_error;
+	int			size_thread_error;
+	struct isl_thread_error	*thread_error;
+
+	struct isl_coalesce_cache	*coalesce_cache;
+};
+
+/* The cheapest test that was able to decide a subset query.
+ * isl_subset_universe: the superset is a universe
+ * isl_subset_plain: the disjuncts of the subset are either syntactically
+ *	contained in a disjunct of the superset or plainly empty
+ * isl_subset_bounds: the remaining disjuncts are separated from
+ *	the superset by bounds on individual variables
+ * isl_subset_exact: an exact test was required
+ */
+enum isl_subset_decision {
+	isl_subset_universe,
+	isl_subset_plain,
+	isl_subset_bounds,
+	isl_subset_exact
 };
 
 int isl_ctx_next_operation(isl_ctx *ctx);
+void isl_ctx_count_pivot(isl_ctx *ctx, int degenerate);
+void isl_ctx_count_gbr_lp(isl_ctx *ctx);
+void isl_ctx_count_double_start(isl_ctx *ctx);
+void isl_ctx_count_subset(isl_ctx *ctx, enum isl_subset_decision decision);
+
+void isl_ctx_lock(isl_ctx *ctx);
+void isl_ctx_unlock(isl_ctx *ctx);
+int isl_ctx_inc_ref(isl_ctx *ctx, int *ref);
+int isl_ctx_dec_ref(isl_ctx *ctx, int *ref);
+int isl_ctx_get_ref(isl_ctx *ctx, int *ref);
+
+isl_int *isl_ctx_get_normalize_gcd(isl_ctx *ctx, isl_int *local);
+void isl_ctx_release_normalize_gcd(isl_ctx *ctx, isl_int *gcd);
+
+void isl_coalesce_cache_clear(isl_ctx *ctx);
@@ -96,8 +96,16 @@ static int isl_id_has_name_and_user(const void *entry, const void *val)
 	return !strcmp(id->name, nu->name);
 }
 
+/* Look up the isl_id with the given name and user pointer in "ctx" and
+ * create it if it does not exist yet.
+ * In thread-safe mode, the lookup in the table of identifiers is
+ * performed while holding the lock of "ctx", such that
+ * the returned identifier cannot get freed by another thread
+ * while its reference count is being incremented.
+ */
 __isl_give isl_id *isl_id_alloc(isl_ctx *ctx, const char *name, void *user)
 {
+	isl_id *id;
 	struct isl_hash_table_entry *entry;
 	uint32_t id_hash;
 	struct isl_name_and_user nu = { name, user };
@@ -110,16 +118,24 @@ __isl_give isl_id *isl_id_alloc(isl_ctx *ctx, const char *name, void *user)
 		id_hash = isl_hash_string(id_hash, name);
 	else
 		id_hash = isl_hash_builtin(id_hash, user);
+	isl_ctx_lock(ctx);
 	entry = isl_hash_table_find(ctx, &ctx->id_table, id_hash,
 					isl_id_has_name_and_user, &nu, 1);
-	if (!entry)
+	if (!entry) {
+		isl_ctx_unlock(ctx);
 		return NULL;
-	if (entry->data)
-		return isl_id_copy(entry->data);
+	}
+	if (entry->data) {
+		id = isl_id_copy(entry->data);
+		isl_ctx_unlock(ctx);
+		return id;
+	}
 	entry->data = id_alloc(ctx, name, user);
 	if (!entry->data)
 		ctx->id_table.n--;
-	return entry->data;
+	id = entry->data;
+	isl_ctx_unlock(ctx);
+	return id;
 }
 
 /* If the id has a negative refcount, then it is a static isl_id
@@ -133,7 +149,7 @@ __isl_give isl_id *isl_id_copy(isl_id *id)
 	if (id->ref < 0)
 		return id;
 
-	id->ref++;
+	isl_ctx_inc_ref(id->ctx, &id->ref);
 	return id;
 }
 
@@ -192,6 +208,10 @@ __isl_give isl_id *isl_id_set_free_user(__isl_take isl_id *id,
 
 /* If the id has a negative refcount, then it is a static isl_id
  * and should not be freed.
+ *
+ * The lock of the context is held while dropping the last reference
+ * and removing the id from the table of identifiers, such that
+ * isl_id_alloc cannot hand out the id again in the mean time.
  */
 __isl_null isl_id *isl_id_free(__isl_take isl_id *id)
 {
@@ -203,8 +223,11 @@ __isl_null isl_id *isl_id_free(__isl_take isl_id *id)
 	if (id->ref < 0)
 		return NULL;
 
-	if (--id->ref > 0)
+	isl_ctx_lock(id->ctx);
+	if (isl_ctx_dec_ref(id->ctx, &id->ref) > 0) {
+		isl_ctx_unlock(id->ctx);
 		return NULL;
+	}
 
 	entry = isl_hash_table_find(id->ctx, &id->ctx->id_table, id->hash,
 					isl_id_eq, id, 0);
@@ -213,6 +236,7 @@ __isl_null isl_id *isl_id_free(__isl_take isl_id *id)
 			"unable to find id", (void)0);
 	else
 		isl_hash_table_remove(id->ctx, &id->ctx->id_table, entry);
+	isl_ctx_unlock(id->ctx);
 
 	if (id->free_user)
 		id->free_user(id->user);
@@ -144,12 +144,20 @@ error:
  * to its value minus 1.
  * If no point can be found, we update l to the upper bound of the interval
  * we checked (u or l+floor(u-l-1/2)) plus 1.
+ *
+ * If "max_steps" is positive and the search has not finished
+ * within that many steps, then *opt is set to l, which is a lower bound
+ * on the minimal value of f over the integer points in "bset", and
+ * *exact is set to 0.  The returned point is then the best solution
+ * found so far and its value for f is greater than *opt.
  */
 static struct isl_vec *solve_ilp_search(struct isl_basic_set *bset,
-	isl_int *f, isl_int *opt, struct isl_vec *sol, isl_int l, isl_int u)
+	isl_int *f, isl_int *opt, struct isl_vec *sol, isl_int l, isl_int u,
+	int max_steps, int *exact)
 {
 	isl_int tmp;
 	int divide = 1;
+	int steps = 0;
 
 	isl_int_init(tmp);
 
@@ -157,6 +165,11 @@ static struct isl_vec *solve_ilp_search(struct isl_basic_set *bset,
 		struct isl_basic_set *slice;
 		struct isl_vec *sample;
 
+		if (max_steps > 0 && steps++ >= max_steps) {
+			isl_int_set(*opt, l);
+			*exact = 0;
+			break;
+		}
 		if (!divide)
 			isl_int_set(tmp, u);
 		else {
@@ -203,11 +216,19 @@ static struct isl_vec *solve_ilp_search(struct isl_basic_set *bset,
  * The initial value of u is the value of f at the initial solution minus 1.
  *
  * We then call solve_ilp_search to perform a binary search on the interval.
+ *
+ * If "max_steps" is positive, then the search is stopped after
+ * that many steps.  If this happens, then *exact is set to 0,
+ * *opt is set to a lower bound on the minimal value and
+ * no integer point is returned in *sol_p since there is
+ * no known point with this value.
  */
 static enum isl_lp_result solve_ilp(struct isl_basic_set *bset,
 				      isl_int *f, isl_int *opt,
-				      struct isl_vec **sol_p)
+				      struct isl_vec **sol_p,
+				      int max_steps, int *exact)
 {
+	int local_exact = 1;
 	enum isl_lp_result res;
 	isl_int l, u;
 	struct isl_vec *sol;
@@ -245,13 +266,18 @@ static enum isl_lp_result solve_ilp(struct isl_basic_set *bset,
 	isl_seq_inner_product(f, sol->el, sol->size, opt);
 	isl_int_sub_ui(u, *opt, 1);
 
-	sol = solve_ilp_search(bset, f, opt, sol, l, u);
+	sol = solve_ilp_search(bset, f, opt, sol, l, u,
+				max_steps, &local_exact);
 	if (!sol)
 		res = isl_lp_error;
 
 	isl_int_clear(l);
 	isl_int_clear(u);
 
+	if (!local_exact) {
+		*exact = 0;
+		sol = isl_vec_free(sol);
+	}
 	if (sol_p)
 		*sol_p = sol;
 	else
@@ -260,9 +286,14 @@ static enum isl_lp_result solve_ilp(struct isl_basic_set *bset,
 	return res;
 }
 
+static enum isl_lp_result basic_set_solve_ilp(struct isl_basic_set *bset,
+	int max, isl_int *f, isl_int *opt, struct isl_vec **sol_p,
+	int max_steps, int *exact);
+
 static enum isl_lp_result solve_ilp_with_eq(struct isl_basic_set *bset, int max,
 				      isl_int *f, isl_int *opt,
-				      struct isl_vec **sol_p)
+				      struct isl_vec **sol_p,
+				      int max_steps, int *exact)
 {
 	unsigned dim;
 	enum isl_lp_result res;
@@ -279,9 +310,10 @@ static enum isl_lp_result solve_ilp_with_eq(struct isl_basic_set *bset, int max,
 	v = isl_vec_mat_product(v, isl_mat_copy(T));
 	if (!v)
 		goto error;
-	res = isl_basic_set_solve_ilp(bset, max, v->el, opt, sol_p);
+	res = basic_set_solve_ilp(bset, max, v->el, opt, sol_p,
+					max_steps, exact);
 	isl_vec_free(v);
-	if (res == isl_lp_ok && sol_p) {
+	if (res == isl_lp_ok && sol_p && *sol_p) {
 		*sol_p = isl_mat_vec_product(T, *sol_p);
 		if (!*sol_p)
 			res = isl_lp_error;
@@ -299,13 +331,16 @@ error:
  * f (if any).
  * If sol_p is not NULL then the integer point is returned in *sol_p.
  * The optimal value of f is returned in *opt.
+ * If "max_steps" is positive, then the search is stopped after that
+ * many steps, in which case *exact is set to 0, *opt is only
+ * a bound on the optimal value and *sol_p is set to NULL.
  *
  * If there is any equality among the points in "bset", then we first
  * project it out.  Otherwise, we continue with solve_ilp above.
  */
-enum isl_lp_result isl_basic_set_solve_ilp(struct isl_basic_set *bset, int max,
-				      isl_int *f, isl_int *opt,
-				      struct isl_vec **sol_p)
+static enum isl_lp_result basic_set_solve_ilp(struct isl_basic_set *bset,
+	int max, isl_int *f, isl_int *opt, struct isl_vec **sol_p,
+	int max_steps, int *exact)
 {
 	unsigned dim;
 	enum isl_lp_result res;
@@ -321,14 +356,15 @@ enum isl_lp_result isl_basic_set_solve_ilp(struct isl_basic_set *bset, int max,
 		return isl_lp_empty;
 
 	if (bset->n_eq)
-		return solve_ilp_with_eq(bset, max, f, opt, sol_p);
+		return solve_ilp_with_eq(bset, max, f, opt, sol_p,
+					max_steps, exact);
 
 	dim = isl_basic_set_total_dim(bset);
 
 	if (max)
 		isl_seq_neg(f, f, 1 + dim);
 
-	res = solve_ilp(bset, f, opt, sol_p);
+	res = solve_ilp(bset, f, opt, sol_p, max_steps, exact);
 
 	if (max) {
 		isl_seq_neg(f, f, 1 + dim);
@@ -341,8 +377,20 @@ error:
 	return isl_lp_error;
 }
 
+/* Find an integer point in "bset" that minimizes (or maximizes if max is set)
+ * f (if any).
+ * If sol_p is not NULL then the integer point is returned in *sol_p.
+ * The optimal value of f is returned in *opt.
+ */
+enum isl_lp_result isl_basic_set_solve_ilp(struct isl_basic_set *bset, int max,
+				      isl_int *f, isl_int *opt,
+				      struct isl_vec **sol_p)
+{
+	return basic_set_solve_ilp(bset, max, f, opt, sol_p, 0, NULL);
+}
+
 static enum isl_lp_result basic_set_opt(__isl_keep isl_basic_set *bset, int max,
-	__isl_keep isl_aff *obj, isl_int *opt)
+	__isl_keep isl_aff *obj, isl_int *opt, int max_steps, int *exact)
 {
 	enum isl_lp_result res;
 
@@ -350,7 +398,8 @@ static enum isl_lp_result basic_set_opt(__isl_keep isl_basic_set *bset, int max,
 		return isl_lp_error;
 	bset = isl_basic_set_copy(bset);
 	bset = isl_basic_set_underlying_set(bset);
-	res = isl_basic_set_solve_ilp(bset, max, obj->v->el + 1, opt, NULL);
+	res = basic_set_solve_ilp(bset, max, obj->v->el + 1, opt, NULL,
+					max_steps, exact);
 	isl_basic_set_free(bset);
 	return res;
 }
@@ -372,8 +421,15 @@ static __isl_give isl_mat *extract_divs(__isl_keep isl_basic_set *bset)
 	return div;
 }
 
-enum isl_lp_result isl_basic_set_opt(__isl_keep isl_basic_set *bset, int max,
-	__isl_keep isl_aff *obj, isl_int *opt)
+/* Compute the minimum (maximum if max is set) of the integer affine
+ * expression obj over the points in bset and put the result in *opt.
+ * If "max_steps" is positive, then the search is stopped after that
+ * many steps, in which case *exact is set to 0 and
+ * *opt is only a bound on the optimal value.
+ */
+static enum isl_lp_result basic_set_opt_bounded(__isl_keep isl_basic_set *bset,
+	int max, __isl_keep isl_aff *obj, isl_int *opt,
+	int max_steps, int *exact)
 {
 	int *exp1 = NULL;
 	int *exp2 = NULL;
@@ -398,7 +454,7 @@ enum isl_lp_result isl_basic_set_opt(__isl_keep isl_basic_set *bset, int max,
 	bset_n_div = isl_basic_set_dim(bset, isl_dim_div);
 	obj_n_div = isl_aff_dim(obj, isl_dim_div);
 	if (bset_n_div == 0 && obj_n_div == 0)
-		return basic_set_opt(bset, max, obj, opt);
+		return basic_set_opt(bset, max, obj, opt, max_steps, exact);
 
 	bset = isl_basic_set_copy(bset);
 	obj = isl_aff_copy(obj);
@@ -414,7 +470,7 @@ enum isl_lp_result isl_basic_set_opt(__isl_keep isl_basic_set *bset, int max,
 	bset = isl_basic_set_expand_divs(bset, isl_mat_copy(div), exp1);
 	obj = isl_aff_expand_divs(obj, isl_mat_copy(div), exp2);
 
-	res = basic_set_opt(bset, max, obj, opt);
+	res = basic_set_opt(bset, max, obj, opt, max_steps, exact);
 
 	isl_mat_free(bset_div);
 	isl_mat_free(div);
@@ -434,13 +490,22 @@ error:
 	return isl_lp_error;
 }
 
+enum isl_lp_result isl_basic_set_opt(__isl_keep isl_basic_set *bset, int max,
+	__isl_keep isl_aff *obj, isl_int *opt)
+{
+	return basic_set_opt_bounded(bset, max, obj, opt, 0, NULL);
+}
+
 /* Compute the minimum (maximum if max is set) of the integer affine
  * expression obj over the points in set and put the result in *opt.
+ * If "max_steps" is positive, then the search is stopped after that
+ * many steps for each basic set, in which case *exact is set to 0 and
+ * *opt is only a bound on the optimal value.
  *
  * The parameters are assumed to have been aligned.
  */
 static enum isl_lp_result isl_set_opt_aligned(__isl_keep isl_set *set, int max,
-	__isl_keep isl_aff *obj, isl_int *opt)
+	__isl_keep isl_aff *obj, isl_int *opt, int max_steps, int *exact)
 {
 	int i;
 	enum isl_lp_result res;
@@ -452,7 +517,8 @@ static enum isl_lp_result isl_set_opt_aligned(__isl_keep isl_set *set, int max,
 	if (set->n == 0)
 		return isl_lp_empty;
 
-	res = isl_basic_set_opt(set->p[0], max, obj, opt);
+	res = basic_set_opt_bounded(set->p[0], max, obj, opt,
+					max_steps, exact);
 	if (res == isl_lp_error || res == isl_lp_unbounded)
 		return res;
 	if (set->n == 1)
@@ -462,7 +528,8 @@ static enum isl_lp_result isl_set_opt_aligned(__isl_keep isl_set *set, int max,
 
 	isl_int_init(opt_i);
 	for (i = 1; i < set->n; ++i) {
-		res = isl_basic_set_opt(set->p[i], max, obj, &opt_i);
+		res = basic_set_opt_bounded(set->p[i], max, obj, &opt_i,
+						max_steps, exact);
 		if (res == isl_lp_error || res == isl_lp_unbounded) {
 			isl_int_clear(opt_i);
 			return res;
@@ -480,9 +547,12 @@ static enum isl_lp_result isl_set_opt_aligned(__isl_keep isl_set *set, int max,
 
 /* Compute the minimum (maximum if max is set) of the integer affine
  * expression obj over the points in set and put the result in *opt.
+ * If "max_steps" is positive, then the search is stopped after that
+ * many steps for each basic set, in which case *exact is set to 0 and
+ * *opt is only a bound on the optimal value.
  */
-enum isl_lp_result isl_set_opt(__isl_keep isl_set *set, int max,
-	__isl_keep isl_aff *obj, isl_int *opt)
+static enum isl_lp_result set_opt_bounded(__isl_keep isl_set *set, int max,
+	__isl_keep isl_aff *obj, isl_int *opt, int max_steps, int *exact)
 {
 	enum isl_lp_result res;
 
@@ -491,14 +561,15 @@ enum isl_lp_result isl_set_opt(__isl_keep isl_set *set, int max,
 
 	if (isl_space_match(set->dim, isl_dim_param,
 			    obj->ls->dim, isl_dim_param))
-		return isl_set_opt_aligned(set, max, obj, opt);
+		return isl_set_opt_aligned(set, max, obj, opt,
+						max_steps, exact);
 
 	set = isl_set_copy(set);
 	obj = isl_aff_copy(obj);
 	set = isl_set_align_params(set, isl_aff_get_domain_space(obj));
 	obj = isl_aff_align_params(obj, isl_set_get_space(set));
 
-	res = isl_set_opt_aligned(set, max, obj, opt);
+	res = isl_set_opt_aligned(set, max, obj, opt, max_steps, exact);
 
 	isl_set_free(set);
 	isl_aff_free(obj);
@@ -506,6 +577,15 @@ enum isl_lp_result isl_set_opt(__isl_keep isl_set *set, int max,
 	return res;
 }
 
+/* Compute the minimum (maximum if max is set) of the integer affine
+ * expression obj over the points in set and put the result in *opt.
+ */
+enum isl_lp_result isl_set_opt(__isl_keep isl_set *set, int max,
+	__isl_keep isl_aff *obj, isl_int *opt)
+{
+	return set_opt_bounded(set, max, obj, opt, 0, NULL);
+}
+
 enum isl_lp_result isl_basic_set_max(__isl_keep isl_basic_set *bset,
 	__isl_keep isl_aff *obj, isl_int *opt)
 {
@@ -643,6 +723,58 @@ __isl_give isl_val *isl_set_max_val(__isl_keep isl_set *set,
 	return isl_set_opt_val(set, 1, obj);
 }
 
+/* Return the minimum (maximum if max is set) of the integer affine
+ * expression "obj" over the points in "set", or a bound on this
+ * optimum if the search for the optimum in any of the basic sets
+ * takes more than "max_steps" steps, with "max_steps" positive.
+ * If "exact" is not NULL, then *exact is set to 1 if the result
+ * is the optimal value and to 0 if it is only a bound.
+ *
+ * Return infinity or negative infinity if the optimal value is unbounded and
+ * NaN if "set" is empty.
+ */
+static __isl_give isl_val *set_opt_val_bounded(__isl_keep isl_set *set,
+	int max, __isl_keep isl_aff *obj, int max_steps, int *exact)
+{
+	isl_ctx *ctx;
+	isl_val *res;
+	enum isl_lp_result lp_res;
+	int local_exact = 1;
+
+	if (!set || !obj)
+		return NULL;
+
+	ctx = isl_aff_get_ctx(obj);
+	res = isl_val_alloc(ctx);
+	if (!res)
+		return NULL;
+	lp_res = set_opt_bounded(set, max, obj, &res->n,
+				max_steps, &local_exact);
+	if (exact)
+		*exact = local_exact;
+	return convert_lp_result(lp_res, res, max);
+}
+
+/* Return the minimum of the integer affine expression "obj"
+ * over the points in "set", or a lower bound on this minimum
+ * if the search takes more than "max_steps" steps for any basic set.
+ */
+__isl_give isl_val *isl_set_min_val_bounded(__isl_keep isl_set *set,
+	__isl_keep isl_aff *obj, int max_steps, int *exact)
+{
+	return set_opt_val_bounded(set, 0, obj, max_steps, exact);
+}
+
+/* Return the maximum of the integer affine expression "obj"
+ * over the points in "set", or an upper bound on this maximum
+ * if the search takes more than "max_steps" steps for any basic set.
+ */
+__isl_give isl_val *isl_set_max_val_bounded(__isl_keep isl_set *set,
+	__isl_keep isl_aff *obj, int max_steps, int *exact)
+{
+	return set_opt_val_bounded(set, 1, obj, max_steps, exact);
+}
+
 /* Return the optimum (min or max depending on "max") of "v1" and "v2",
  * where either may be NaN, signifying an uninitialized value.
  * That is, if either is NaN, then return the other one.
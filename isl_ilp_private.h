@@ -7,5 +7,7 @@
 
 enum isl_lp_result isl_basic_set_solve_ilp(__isl_keep isl_basic_set *bset,
 	int max, isl_int *f, isl_int *opt, __isl_give isl_vec **sol_p);
+__isl_give isl_val *isl_basic_set_opt_val(__isl_keep isl_basic_set *bset,
+	int max, __isl_keep isl_aff *obj);
 
 #endif
@@ -22,19 +22,17 @@
 #include <bset_to_bmap.c>
 #include <set_to_map.c>
 
-enum isl_lp_result isl_tab_solve_lp(struct isl_basic_map *bmap, int maximize,
-				      isl_int *f, isl_int denom, isl_int *opt,
-				      isl_int *opt_denom,
-				      struct isl_vec **sol)
+/* Compute the minimum of "f"/"denom" over "bmap" using a tableau,
+ * storing the optimum in *opt / *opt_denom and the optimal point in *sol
+ * (if "sol" is not NULL).
+ */
+static enum isl_lp_result tab_solve_lp(__isl_keep isl_basic_map *bmap,
+	isl_int *f, isl_int denom, isl_int *opt, isl_int *opt_denom,
+	__isl_give isl_vec **sol)
 {
 	struct isl_tab *tab;
 	enum isl_lp_result res;
-	unsigned dim = isl_basic_map_total_dim(bmap);
 
-	if (maximize)
-		isl_seq_neg(f, f, 1 + dim);
-
-	bmap = isl_basic_map_gauss(bmap, NULL);
 	tab = isl_tab_from_basic_map(bmap, 0);
 	res = isl_tab_min(tab, f, denom, opt, opt_denom, 0);
 	if (res == isl_lp_ok && sol) {
@@ -44,6 +42,260 @@ enum isl_lp_result isl_tab_solve_lp(struct isl_basic_map *bmap, int maximize,
 	}
 	isl_tab_free(tab);
 
+	return res;
+}
+
+/* Information about the inequalities removed by presolve_lp.
+ *
+ * "dropped" contains the "n" removed inequalities, in the order
+ * in which they were removed.
+ * "var"[i] is the variable that caused the removal of inequality i.
+ */
+struct isl_lp_presolve {
+	isl_mat *dropped;
+	int *var;
+	int n;
+};
+
+/* Does variable "pos" of "bmap" appear in any of its equalities?
+ */
+static int involved_in_equality(__isl_keep isl_basic_map *bmap, int pos)
+{
+	int i;
+
+	for (i = 0; i < bmap->n_eq; ++i)
+		if (!isl_int_is_zero(bmap->eq[i][1 + pos]))
+			return 1;
+
+	return 0;
+}
+
+/* Return the sign of the coefficients of variable "pos"
+ * in the inequalities of "bmap", 0 if the variable does not appear
+ * in any inequality and 2 if it appears with both signs.
+ */
+static int ineq_sign(__isl_keep isl_basic_map *bmap, int pos)
+{
+	int i;
+	int sign = 0;
+
+	for (i = 0; i < bmap->n_ineq; ++i) {
+		int s = isl_int_sgn(bmap->ineq[i][1 + pos]);
+
+		if (s == 0)
+			continue;
+		if (sign && s != sign)
+			return 2;
+		sign = s;
+	}
+
+	return sign;
+}
+
+/* Move the inequalities of "bmap" involving variable "pos"
+ * to "ps".
+ */
+static __isl_give isl_basic_map *drop_var_ineqs(__isl_take isl_basic_map *bmap,
+	int pos, struct isl_lp_presolve *ps)
+{
+	int i;
+	unsigned total = isl_basic_map_total_dim(bmap);
+
+	for (i = bmap->n_ineq - 1; i >= 0; --i) {
+		if (isl_int_is_zero(bmap->ineq[i][1 + pos]))
+			continue;
+		isl_seq_cpy(ps->dropped->row[ps->n], bmap->ineq[i], 1 + total);
+		ps->var[ps->n++] = pos;
+		if (isl_basic_map_drop_inequality(bmap, i) < 0)
+			return isl_basic_map_free(bmap);
+	}
+
+	return bmap;
+}
+
+/* Simplify the LP of minimizing "f" over "bmap" without changing
+ * the optimal value, recording the information that is needed
+ * to recover an optimal point of the original problem in "ps".
+ *
+ * First remove duplicate inequalities and combine pairs of opposite
+ * inequalities into equalities.
+ * Then look for variables that do not appear in "f" or in any equality
+ * and that appear with the same sign in all inequalities that
+ * involve them.  Such a variable can always be chosen in such
+ * a way that those inequalities are satisfied, so they can be removed
+ * from the problem.  Since this may allow more variables
+ * to be handled in the same way, repeat until no more progress is made.
+ * The variables themselves are kept, such that the positions
+ * of the other variables do not change.  They no longer appear
+ * in any constraint and therefore do not affect the size
+ * of the tableau.
+ */
+static __isl_give isl_basic_map *presolve_lp(__isl_take isl_basic_map *bmap,
+	isl_int *f, struct isl_lp_presolve *ps)
+{
+	int i;
+	int progress;
+	unsigned total;
+
+	progress = 0;
+	bmap = isl_basic_map_cow(bmap);
+	bmap = isl_basic_map_detect_inequality_pairs(bmap, &progress);
+	if (progress)
+		bmap = isl_basic_map_gauss(bmap, NULL);
+	if (!bmap)
+		return NULL;
+
+	total = isl_basic_map_total_dim(bmap);
+	ps->dropped = isl_mat_alloc(bmap->ctx, bmap->n_ineq, 1 + total);
+	ps->var = isl_alloc_array(bmap->ctx, int, bmap->n_ineq);
+	if (!ps->dropped || (bmap->n_ineq && !ps->var))
+		return isl_basic_map_free(bmap);
+
+	do {
+		progress = 0;
+		for (i = 0; i < total; ++i) {
+			int sign;
+
+			if (!isl_int_is_zero(f[1 + i]))
+				continue;
+			if (involved_in_equality(bmap, i))
+				continue;
+			sign = ineq_sign(bmap, i);
+			if (sign == 0 || sign == 2)
+				continue;
+			bmap = drop_var_ineqs(bmap, i, ps);
+			if (!bmap)
+				return NULL;
+			progress = 1;
+		}
+	} while (progress);
+
+	return bmap;
+}
+
+/* Update the optimal point "sol" of the LP simplified by presolve_lp
+ * to an optimal point of the original LP.
+ *
+ * The variables that caused inequalities to be removed
+ * do not appear in the simplified problem and have a zero value in "sol".
+ * Handle them in the opposite order in which they were considered
+ * by presolve_lp.  The inequalities removed because of a given variable
+ * only involve variables that have already been handled, so
+ * the value of the variable can be set to the greatest lower bound
+ * or the smallest upper bound implied by these inequalities.
+ * The value of the variable in "sol" is then set to this bound,
+ * after rescaling the common denominator of "sol" if needed.
+ */
+static __isl_give isl_vec *postsolve_lp(__isl_take isl_vec *sol,
+	struct isl_lp_presolve *ps)
+{
+	int i, k;
+	isl_int v, n, d, best_n, best_d, t;
+
+	if (!sol || ps->n == 0)
+		return sol;
+
+	isl_int_init(v);
+	isl_int_init(n);
+	isl_int_init(d);
+	isl_int_init(best_n);
+	isl_int_init(best_d);
+	isl_int_init(t);
+	for (i = ps->n - 1; i >= 0; i = k) {
+		int pos = ps->var[i];
+		int sign;
+
+		sign = isl_int_sgn(ps->dropped->row[i][1 + pos]);
+		for (k = i; k >= 0 && ps->var[k] == pos; --k) {
+			isl_int *c = ps->dropped->row[k];
+
+			isl_seq_inner_product(c + 1, sol->el + 1,
+						sol->size - 1, &v);
+			isl_int_addmul(v, c[0], sol->el[0]);
+			isl_int_mul(d, c[1 + pos], sol->el[0]);
+			isl_int_neg(n, v);
+			if (sign < 0) {
+				isl_int_neg(n, n);
+				isl_int_neg(d, d);
+			}
+			if (k != i) {
+				isl_int_mul(v, n, best_d);
+				isl_int_mul(t, best_n, d);
+				if (sign > 0 ? isl_int_le(v, t) :
+					       isl_int_ge(v, t))
+					continue;
+			}
+			isl_int_set(best_n, n);
+			isl_int_set(best_d, d);
+		}
+		isl_int_lcm(t, sol->el[0], best_d);
+		isl_int_divexact(v, t, sol->el[0]);
+		isl_seq_scale(sol->el, sol->el, v, sol->size);
+		isl_int_divexact(v, t, best_d);
+		isl_int_mul(sol->el[1 + pos], best_n, v);
+	}
+	isl_int_clear(t);
+	isl_int_clear(best_d);
+	isl_int_clear(best_n);
+	isl_int_clear(d);
+	isl_int_clear(n);
+	isl_int_clear(v);
+
+	return isl_vec_normalize(sol);
+}
+
+/* Compute the minimum of "f"/"denom" over "bmap" as in tab_solve_lp,
+ * but after simplifying the problem using presolve_lp.
+ * If an optimal point is requested, then the optimal point
+ * of the simplified problem is mapped back to an optimal point
+ * of the original problem.
+ */
+static enum isl_lp_result solve_presolved_lp(__isl_keep isl_basic_map *bmap,
+	isl_int *f, isl_int denom, isl_int *opt, isl_int *opt_denom,
+	__isl_give isl_vec **sol)
+{
+	struct isl_lp_presolve ps = { NULL, NULL, 0 };
+	enum isl_lp_result res;
+
+	bmap = presolve_lp(isl_basic_map_copy(bmap), f, &ps);
+	if (!bmap)
+		res = isl_lp_error;
+	else
+		res = tab_solve_lp(bmap, f, denom, opt, opt_denom, sol);
+	if (res == isl_lp_ok && sol) {
+		*sol = postsolve_lp(*sol, &ps);
+		if (!*sol)
+			res = isl_lp_error;
+	}
+	isl_basic_map_free(bmap);
+	isl_mat_free(ps.dropped);
+	free(ps.var);
+
+	return res;
+}
+
+/* Compute the minimum (or maximum if "maximize" is set)
+ * of "f"/"denom" over "bmap".
+ * If the lp_presolve option is set, then the problem is first simplified
+ * by solve_presolved_lp.
+ */
+enum isl_lp_result isl_tab_solve_lp(struct isl_basic_map *bmap, int maximize,
+				      isl_int *f, isl_int denom, isl_int *opt,
+				      isl_int *opt_denom,
+				      struct isl_vec **sol)
+{
+	enum isl_lp_result res;
+	unsigned dim = isl_basic_map_total_dim(bmap);
+
+	if (maximize)
+		isl_seq_neg(f, f, 1 + dim);
+
+	bmap = isl_basic_map_gauss(bmap, NULL);
+	if (bmap && bmap->ctx->opt->lp_presolve)
+		res = solve_presolved_lp(bmap, f, denom, opt, opt_denom, sol);
+	else
+		res = tab_solve_lp(bmap, f, denom, opt, opt_denom, sol);
+
 	if (maximize)
 		isl_seq_neg(f, f, 1 + dim);
 	if (maximize && opt)
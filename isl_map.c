@@ -3099,15 +3099,265 @@ error:
 	return NULL;
 }
 
+/* Update the bound at position "pos" of "box" with the value "v".
+ * If "upper" is set, then "v" is an upper bound.
+ * Otherwise, it is a lower bound.
+ * Mark "box" empty if the lower bound exceeds the upper bound.
+ */
+void isl_map_box_update(struct isl_map_box *box, int pos, int upper,
+	isl_int v)
+{
+	isl_int *bound = &box->bound->el[2 * pos + upper];
+
+	if (!box->bounded[2 * pos + upper])
+		isl_int_set(*bound, v);
+	else if (upper && isl_int_lt(v, *bound))
+		isl_int_set(*bound, v);
+	else if (!upper && isl_int_gt(v, *bound))
+		isl_int_set(*bound, v);
+	box->bounded[2 * pos + upper] = 1;
+
+	if (box->bounded[2 * pos] && box->bounded[2 * pos + 1] &&
+	    isl_int_gt(box->bound->el[2 * pos], box->bound->el[2 * pos + 1]))
+		box->empty = 1;
+}
+
+/* If "c" is a constraint that only involves the variable
+ * at position "pos", with "pos" smaller than "dim",
+ * then update the corresponding bounds of "box".
+ * "total" is the total number of variables.
+ * If "eq" is set, then "c" is an equality constraint and
+ * it provides both a lower and an upper bound, unless
+ * the constant term is not a multiple of the coefficient, in which
+ * case the basic map is empty.
+ * If "unit" is set, then only constraints with a unit coefficient
+ * are taken into account.  The bounds derived from such constraints
+ * are exact.  Otherwise, the variables are assumed to take
+ * integer values and the bounds derived from inequality constraints
+ * are rounded.
+ */
+void isl_map_box_add_constraint(struct isl_map_box *box, isl_int *c,
+	int eq, unsigned total, unsigned dim, int unit)
+{
+	int pos;
+	isl_int v, a;
+
+	pos = isl_seq_first_non_zero(c + 1, total);
+	if (pos < 0 || pos >= dim)
+		return;
+	if (isl_seq_first_non_zero(c + 1 + pos + 1, total - pos - 1) >= 0)
+		return;
+	if (unit && !isl_int_is_one(c[1 + pos]) &&
+	    !isl_int_is_negone(c[1 + pos]))
+		return;
+
+	isl_int_init(v);
+	isl_int_init(a);
+	if (eq) {
+		if (!isl_int_is_divisible_by(c[0], c[1 + pos])) {
+			box->empty = 1;
+		} else {
+			isl_int_divexact(v, c[0], c[1 + pos]);
+			isl_int_neg(v, v);
+			isl_map_box_update(box, pos, 0, v);
+			isl_map_box_update(box, pos, 1, v);
+		}
+	} else if (isl_int_is_pos(c[1 + pos])) {
+		isl_int_neg(v, c[0]);
+		isl_int_cdiv_q(v, v, c[1 + pos]);
+		isl_map_box_update(box, pos, 0, v);
+	} else {
+		isl_int_neg(a, c[1 + pos]);
+		isl_int_fdiv_q(v, c[0], a);
+		isl_map_box_update(box, pos, 1, v);
+	}
+	isl_int_clear(a);
+	isl_int_clear(v);
+}
+
+/* Allocate room in "box" for bounds on "dim" variables,
+ * none of which are available yet.
+ */
+isl_stat isl_map_box_alloc(struct isl_map_box *box, isl_ctx *ctx,
+	unsigned dim)
+{
+	box->empty = 0;
+	box->bound = isl_vec_alloc(ctx, 2 * dim);
+	box->bounded = isl_calloc_array(ctx, int, 2 * dim);
+	if (!box->bound || (dim && !box->bounded))
+		return isl_stat_error;
+	return isl_stat_ok;
+}
+
+/* Free the memory allocated for "box", if any,
+ * marking the bounds as not having been computed.
+ */
+void isl_map_box_clear(struct isl_map_box *box)
+{
+	box->bound = isl_vec_free(box->bound);
+	free(box->bounded);
+	box->bounded = NULL;
+}
+
+/* Compute bounds on the non-local variables of "bmap" in "box"
+ * from the constraints of "bmap" that involve a single
+ * such variable.
+ * No bounds are computed for rational basic maps since
+ * the rounding performed by isl_map_box_add_constraint is not valid
+ * for such basic maps.
+ */
+static isl_stat map_box_init(struct isl_map_box *box,
+	__isl_keep isl_basic_map *bmap)
+{
+	int k;
+	unsigned total, dim;
+
+	box->empty = 0;
+	box->bound = NULL;
+	box->bounded = NULL;
+	if (!bmap)
+		return isl_stat_error;
+	if (ISL_F_ISSET(bmap, ISL_BASIC_MAP_EMPTY)) {
+		box->empty = 1;
+		return isl_stat_ok;
+	}
+	if (ISL_F_ISSET(bmap, ISL_BASIC_MAP_RATIONAL))
+		return isl_stat_ok;
+
+	total = isl_basic_map_total_dim(bmap);
+	dim = isl_space_dim(bmap->dim, isl_dim_all);
+	if (isl_map_box_alloc(box, bmap->ctx, dim) < 0)
+		return isl_stat_error;
+
+	for (k = 0; !box->empty && k < bmap->n_eq; ++k)
+		isl_map_box_add_constraint(box, bmap->eq[k], 1, total, dim, 0);
+	for (k = 0; !box->empty && k < bmap->n_ineq; ++k)
+		isl_map_box_add_constraint(box, bmap->ineq[k], 0, total, dim, 0);
+
+	return isl_stat_ok;
+}
+
+/* Free the "n" elements of "boxes" along with "boxes" itself.
+ */
+void isl_map_boxes_free(struct isl_map_box *boxes, int n)
+{
+	int i;
+
+	if (!boxes)
+		return;
+	for (i = 0; i < n; ++i)
+		isl_map_box_clear(&boxes[i]);
+	free(boxes);
+}
+
+/* Compute the bounds of each of the basic maps in "map".
+ * "map" is assumed to consist of at least one basic map,
+ * such that a NULL return value always signals an error.
+ */
+struct isl_map_box *isl_map_boxes(__isl_keep isl_map *map)
+{
+	int i;
+	struct isl_map_box *boxes;
+
+	if (!map)
+		return NULL;
+	if (map->n == 0)
+		isl_die(map->ctx, isl_error_internal,
+			"expecting at least one basic map", return NULL);
+	boxes = isl_calloc_array(map->ctx, struct isl_map_box, map->n);
+	if (!boxes)
+		return NULL;
+	for (i = 0; i < map->n; ++i)
+		if (map_box_init(&boxes[i], map->p[i]) < 0) {
+			isl_map_boxes_free(boxes, map->n);
+			return NULL;
+		}
+
+	return boxes;
+}
+
+/* Do the bounds in "box1" and "box2" show that the basic maps
+ * they belong to cannot have any element in common?
+ * Only the "n" variables starting at position "pos1" in "box1" and
+ * those starting at position "pos2" in "box2" are compared.
+ * This is the case if one of the basic maps is empty or
+ * if any of these variables has a lower bound in one box
+ * that is greater than the upper bound in the other box.
+ */
+static int map_box_separated(struct isl_map_box *box1, int pos1,
+	struct isl_map_box *box2, int pos2, int n)
+{
+	int k;
+
+	if (box1->empty || box2->empty)
+		return 1;
+	if (!box1->bound || !box2->bound)
+		return 0;
+
+	for (k = 0; k < n; ++k) {
+		int l1 = 2 * (pos1 + k), l2 = 2 * (pos2 + k);
+
+		if (box1->bounded[l1] && box2->bounded[l2 + 1] &&
+		    isl_int_gt(box1->bound->el[l1], box2->bound->el[l2 + 1]))
+			return 1;
+		if (box2->bounded[l2] && box1->bounded[l1 + 1] &&
+		    isl_int_gt(box2->bound->el[l2], box1->bound->el[l1 + 1]))
+			return 1;
+	}
+
+	return 0;
+}
+
+/* Do the bounds on the individual non-local variables show
+ * that "bmap" does not have any element in common with "map"?
+ * "boxes" contains the bounds of the basic maps in "map",
+ * as computed by isl_map_boxes.
+ * "bmap" and "map" are assumed to live in the same space.
+ */
+isl_bool isl_basic_map_plain_is_box_disjoint(__isl_keep isl_basic_map *bmap,
+	__isl_keep isl_map *map, struct isl_map_box *boxes)
+{
+	int i;
+	unsigned dim;
+	struct isl_map_box box;
+	isl_bool disjoint = isl_bool_true;
+
+	if (!bmap || !map || (map->n && !boxes))
+		return isl_bool_error;
+	if (map_box_init(&box, bmap) < 0) {
+		isl_map_box_clear(&box);
+		return isl_bool_error;
+	}
+
+	dim = isl_space_dim(map->dim, isl_dim_all);
+	for (i = 0; disjoint && i < map->n; ++i)
+		if (!map_box_separated(&box, 0, &boxes[i], 0, dim))
+			disjoint = isl_bool_false;
+
+	isl_map_box_clear(&box);
+	return disjoint;
+}
+
 /* map2 may be either a parameter domain or a map living in the same
  * space as map1.
+ *
+ * If map1 or map2 consists of several basic maps, neither of them
+ * is empty and if they live in the same space,
+ * then the pairs of basic maps that are separated
+ * by the bounds on their variables are skipped without
+ * constructing their intersection.
+ * No further (LP based) emptiness checks are performed on the pairs
+ * since the intersections of most pairs are typically non-empty.
  */
 static __isl_give isl_map *map_intersect_internal(__isl_take isl_map *map1,
 	__isl_take isl_map *map2)
 {
 	unsigned flags = 0;
 	isl_map *result;
+	struct isl_map_box *box1 = NULL, *box2 = NULL;
 	int i, j;
+	int n1 = 0, n2 = 0;
+	unsigned dim;
 
 	if (!map1 || !map2)
 		goto error;
@@ -3141,13 +3391,32 @@ static __isl_give isl_map *map_intersect_internal(__isl_take isl_map *map1,
 	    ISL_F_ISSET(map2, ISL_MAP_DISJOINT))
 		ISL_FL_SET(flags, ISL_MAP_DISJOINT);
 
+	n1 = map1->n;
+	n2 = map2->n;
+	dim = isl_space_dim(map1->dim, isl_dim_all);
+	if (n1 > 0 && n2 > 0 && (n1 >= 2 || n2 >= 2)) {
+		isl_bool equal;
+
+		equal = isl_space_is_equal(map1->dim, map2->dim);
+		if (equal < 0)
+			goto error;
+		if (equal) {
+			box1 = isl_map_boxes(map1);
+			box2 = isl_map_boxes(map2);
+			if (!box1 || !box2)
+				goto error;
+		}
+	}
 	result = isl_map_alloc_space(isl_space_copy(map1->dim),
 				map1->n * map2->n, flags);
 	if (!result)
 		goto error;
-	for (i = 0; i < map1->n; ++i)
+	for (i = 0; i < map1->n; ++i) {
 		for (j = 0; j < map2->n; ++j) {
 			struct isl_basic_map *part;
+			if (box1 &&
+			    map_box_separated(&box1[i], 0, &box2[j], 0, dim))
+				continue;
 			part = isl_basic_map_intersect(
 				    isl_basic_map_copy(map1->p[i]),
 				    isl_basic_map_copy(map2->p[j]));
@@ -3157,10 +3426,15 @@ static __isl_give isl_map *map_intersect_internal(__isl_take isl_map *map1,
 			if (!result)
 				goto error;
 		}
+	}
+	isl_map_boxes_free(box1, n1);
+	isl_map_boxes_free(box2, n2);
 	isl_map_free(map1);
 	isl_map_free(map2);
 	return result;
 error:
+	isl_map_boxes_free(box1, n1);
+	isl_map_boxes_free(box2, n2);
 	isl_map_free(map1);
 	isl_map_free(map2);
 	return NULL;
@@ -6546,10 +6820,13 @@ static struct isl_basic_set *basic_set_parameter_preimage(
 	bset->dim->nparam = 0;
 	bset->dim->n_out = nparam;
 	bset = isl_basic_set_preimage(bset, mat);
-	if (bset) {
-		bset->dim->nparam = bset->dim->n_out;
-		bset->dim->n_out = 0;
-	}
+	if (!bset)
+		return NULL;
+	bset->dim = isl_space_cow(bset->dim);
+	if (!bset->dim)
+		return isl_basic_set_free(bset);
+	bset->dim->nparam = bset->dim->n_out;
+	bset->dim->n_out = 0;
 	return bset;
 error:
 	isl_mat_free(mat);
@@ -7417,16 +7694,55 @@ __isl_give isl_map *isl_map_apply_domain(__isl_take isl_map *map1,
 	return isl_map_align_params_map_map_and(map1, map2, &map_apply_domain);
 }
 
+/* Is the composition of the basic maps at position "i" in "map1" and
+ * position "j" in "map2" obviously empty, based on the bounds
+ * in "box1" and "box2"?
+ * That is, are the parameters or the range of the first basic map
+ * separated from the parameters or the domain of the second basic map?
+ */
+static int apply_range_separated(__isl_keep isl_map *map1,
+	struct isl_map_box *box1, int i, __isl_keep isl_map *map2,
+	struct isl_map_box *box2, int j)
+{
+	unsigned nparam, n_in, n_out;
+
+	nparam = isl_space_dim(map1->dim, isl_dim_param);
+	n_in = isl_space_dim(map1->dim, isl_dim_in);
+	n_out = isl_space_dim(map1->dim, isl_dim_out);
+
+	return map_box_separated(&box1[i], 0, &box2[j], 0, nparam) ||
+	    map_box_separated(&box1[i], nparam + n_in, &box2[j], nparam, n_out);
+}
+
+/* Compose "map1" and "map2" by composing each pair of basic maps.
+ *
+ * If map1 or map2 consists of several basic maps and
+ * neither of them is empty, then
+ * the pairs of basic maps for which the bounds on the variables
+ * show that the range of the first does not intersect
+ * the domain of the second are skipped.
+ */
 static __isl_give isl_map *map_apply_range(__isl_take isl_map *map1,
 	__isl_take isl_map *map2)
 {
 	isl_space *dim_result;
 	struct isl_map *result;
+	struct isl_map_box *box1 = NULL, *box2 = NULL;
 	int i, j;
+	int n1 = 0, n2 = 0;
 
 	if (!map1 || !map2)
 		goto error;
 
+	n1 = map1->n;
+	n2 = map2->n;
+	if (n1 > 0 && n2 > 0 && (n1 >= 2 || n2 >= 2)) {
+		box1 = isl_map_boxes(map1);
+		box2 = isl_map_boxes(map2);
+		if (!box1 || !box2)
+			goto error;
+	}
+
 	dim_result = isl_space_join(isl_space_copy(map1->dim),
 				  isl_space_copy(map2->dim));
 
@@ -7435,6 +7751,9 @@ static __isl_give isl_map *map_apply_range(__isl_take isl_map *map1,
 		goto error;
 	for (i = 0; i < map1->n; ++i)
 		for (j = 0; j < map2->n; ++j) {
+			if (box1 && apply_range_separated(map1, box1, i,
+							map2, box2, j))
+				continue;
 			result = isl_map_add_basic_map(result,
 			    isl_basic_map_apply_range(
 				isl_basic_map_copy(map1->p[i]),
@@ -7442,12 +7761,16 @@ static __isl_give isl_map *map_apply_range(__isl_take isl_map *map1,
 			if (!result)
 				goto error;
 		}
+	isl_map_boxes_free(box1, n1);
+	isl_map_boxes_free(box2, n2);
 	isl_map_free(map1);
 	isl_map_free(map2);
 	if (result && result->n <= 1)
 		ISL_F_SET(result, ISL_MAP_DISJOINT);
 	return result;
 error:
+	isl_map_boxes_free(box1, n1);
+	isl_map_boxes_free(box2, n2);
 	isl_map_free(map1);
 	isl_map_free(map2);
 	return NULL;
@@ -13187,18 +13510,20 @@ __isl_give isl_set *isl_set_preimage_multi_pw_aff(__isl_take isl_set *set,
 static isl_bool is_internal(__isl_keep isl_vec *inner,
 	__isl_keep isl_basic_set *bset, int ineq)
 {
-	isl_ctx *ctx;
-	int pos;
+	isl_int prod;
+	int pos, sgn;
 	unsigned total;
 
 	if (!inner || !bset)
 		return isl_bool_error;
 
-	ctx = isl_basic_set_get_ctx(bset);
+	isl_int_init(prod);
 	isl_seq_inner_product(inner->el, bset->ineq[ineq], inner->size,
-				&ctx->normalize_gcd);
-	if (!isl_int_is_zero(ctx->normalize_gcd))
-		return isl_int_is_nonneg(ctx->normalize_gcd);
+				&prod);
+	sgn = isl_int_sgn(prod);
+	isl_int_clear(prod);
+	if (sgn != 0)
+		return sgn > 0;
 
 	total = isl_basic_set_dim(bset, isl_dim_all);
 	pos = isl_seq_first_non_zero(bset->ineq[ineq] + 1, total);
@@ -0,0 +1,325 @@
+/*
+ * Copyright 2017      Sven Verdoolaege
+ *
+ * Use of this software is governed by the MIT license
+ */
+
+#include <isl_ctx_private.h>
+#include <isl_map_private.h>
+#include <isl/map_pipeline.h>
+
+/* A chain of operations on a map, the evaluation of which
+ * is deferred until the result is requested.
+ *
+ * "map" is the first map in the chain and "range" contains the "n" maps
+ * that still need to be applied to the range of "map", in order.
+ * "size" is the number of allocated elements in "range".
+ * "coalesce" is set if the result should be coalesced.
+ *
+ * Domain intersections and projections of input dimensions
+ * are applied to "map" directly, while projections of output dimensions
+ * are applied to the last map in the chain, such that they are
+ * performed on the individual maps before they get composed.
+ * Coalescing is only performed once, on the final result.
+ */
+struct isl_map_pipeline {
+	int ref;
+	isl_ctx *ctx;
+
+	isl_map *map;
+
+	int n;
+	int size;
+	isl_map **range;
+
+	int coalesce;
+};
+
+/* Construct a pipeline that initially represents "map".
+ */
+__isl_give isl_map_pipeline *isl_map_pipeline_from_map(
+	__isl_take isl_map *map)
+{
+	isl_ctx *ctx;
+	isl_map_pipeline *pipeline;
+
+	if (!map)
+		return NULL;
+
+	ctx = isl_map_get_ctx(map);
+	pipeline = isl_calloc_type(ctx, struct isl_map_pipeline);
+	if (!pipeline)
+		goto error;
+
+	pipeline->ref = 1;
+	pipeline->ctx = ctx;
+	isl_ctx_ref(ctx);
+	pipeline->map = map;
+
+	return pipeline;
+error:
+	isl_map_free(map);
+	return NULL;
+}
+
+isl_ctx *isl_map_pipeline_get_ctx(__isl_keep isl_map_pipeline *pipeline)
+{
+	return pipeline ? pipeline->ctx : NULL;
+}
+
+__isl_give isl_map_pipeline *isl_map_pipeline_copy(
+	__isl_keep isl_map_pipeline *pipeline)
+{
+	if (!pipeline)
+		return NULL;
+
+	pipeline->ref++;
+	return pipeline;
+}
+
+/* Return a fresh copy of "pipeline" that shares its maps
+ * with the original.
+ */
+static __isl_give isl_map_pipeline *isl_map_pipeline_dup(
+	__isl_keep isl_map_pipeline *pipeline)
+{
+	int i;
+	isl_map_pipeline *dup;
+
+	if (!pipeline)
+		return NULL;
+
+	dup = isl_map_pipeline_from_map(isl_map_copy(pipeline->map));
+	if (!dup)
+		return NULL;
+	if (pipeline->n > 0) {
+		dup->range = isl_alloc_array(pipeline->ctx, isl_map *,
+						pipeline->n);
+		if (!dup->range)
+			return isl_map_pipeline_free(dup);
+		dup->size = pipeline->n;
+	}
+	for (i = 0; i < pipeline->n; ++i)
+		dup->range[dup->n++] = isl_map_copy(pipeline->range[i]);
+	dup->coalesce = pipeline->coalesce;
+
+	return dup;
+}
+
+/* Return a pipeline equal to "pipeline" that is only referenced
+ * by the caller, such that it can be modified in place.
+ */
+static __isl_give isl_map_pipeline *isl_map_pipeline_cow(
+	__isl_take isl_map_pipeline *pipeline)
+{
+	if (!pipeline)
+		return NULL;
+
+	if (pipeline->ref == 1)
+		return pipeline;
+	pipeline->ref--;
+	return isl_map_pipeline_dup(pipeline);
+}
+
+__isl_null isl_map_pipeline *isl_map_pipeline_free(
+	__isl_take isl_map_pipeline *pipeline)
+{
+	int i;
+
+	if (!pipeline)
+		return NULL;
+
+	if (--pipeline->ref > 0)
+		return NULL;
+
+	isl_map_free(pipeline->map);
+	for (i = 0; i < pipeline->n; ++i)
+		isl_map_free(pipeline->range[i]);
+	free(pipeline->range);
+	isl_ctx_deref(pipeline->ctx);
+	free(pipeline);
+
+	return NULL;
+}
+
+/* Return the last map in the chain of "pipeline",
+ * i.e., the map the range of which is the range of the result.
+ */
+static isl_map **pipeline_last(__isl_keep isl_map_pipeline *pipeline)
+{
+	if (pipeline->n == 0)
+		return &pipeline->map;
+	return &pipeline->range[pipeline->n - 1];
+}
+
+/* Compose the maps in the chain of "pipeline",
+ * leaving only "pipeline->map".
+ */
+static __isl_give isl_map_pipeline *pipeline_compose(
+	__isl_take isl_map_pipeline *pipeline)
+{
+	int i;
+
+	if (!pipeline || pipeline->n == 0)
+		return pipeline;
+
+	pipeline = isl_map_pipeline_cow(pipeline);
+	if (!pipeline)
+		return NULL;
+
+	for (i = 0; i < pipeline->n; ++i) {
+		pipeline->map = isl_map_apply_range(pipeline->map,
+						    pipeline->range[i]);
+		pipeline->range[i] = NULL;
+	}
+	pipeline->n = 0;
+	if (!pipeline->map)
+		return isl_map_pipeline_free(pipeline);
+
+	return pipeline;
+}
+
+/* Append "map" to the chain of "pipeline".
+ * The domain of "map" is required to match the range of the result
+ * represented by "pipeline", apart from the parameters, which
+ * get aligned when the chain is composed.
+ */
+__isl_give isl_map_pipeline *isl_map_pipeline_apply_range(
+	__isl_take isl_map_pipeline *pipeline, __isl_take isl_map *map)
+{
+	isl_bool equal;
+
+	pipeline = isl_map_pipeline_cow(pipeline);
+	if (!pipeline || !map)
+		goto error;
+
+	equal = isl_space_tuple_is_equal((*pipeline_last(pipeline))->dim,
+					isl_dim_out, map->dim, isl_dim_in);
+	if (equal < 0)
+		goto error;
+	if (!equal)
+		isl_die(pipeline->ctx, isl_error_invalid,
+			"spaces don't match", goto error);
+
+	if (pipeline->n >= pipeline->size) {
+		isl_map **range;
+		int size = 3 * pipeline->size / 2 + 4;
+
+		range = isl_realloc_array(pipeline->ctx, pipeline->range,
+					isl_map *, size);
+		if (!range)
+			goto error;
+		pipeline->range = range;
+		pipeline->size = size;
+	}
+
+	pipeline->range[pipeline->n++] = map;
+
+	return pipeline;
+error:
+	isl_map_free(map);
+	isl_map_pipeline_free(pipeline);
+	return NULL;
+}
+
+/* Intersect the domain of the result represented by "pipeline" with "set".
+ * Since the domain of the result is that of the first map in the chain,
+ * the intersection is performed on this first map,
+ * before any of the other maps get applied to it.
+ */
+__isl_give isl_map_pipeline *isl_map_pipeline_intersect_domain(
+	__isl_take isl_map_pipeline *pipeline, __isl_take isl_set *set)
+{
+	pipeline = isl_map_pipeline_cow(pipeline);
+	if (!pipeline)
+		goto error;
+
+	pipeline->map = isl_map_intersect_domain(pipeline->map, set);
+	if (!pipeline->map)
+		return isl_map_pipeline_free(pipeline);
+
+	return pipeline;
+error:
+	isl_set_free(set);
+	return NULL;
+}
+
+/* Project out the "n" dimensions of type "type" starting at "first"
+ * from the result represented by "pipeline".
+ *
+ * Input dimensions are projected out of the first map in the chain and
+ * output dimensions are projected out of the last map in the chain.
+ * Since the parameters are shared by all maps in the chain,
+ * they can only be projected out after the chain has been composed.
+ */
+__isl_give isl_map_pipeline *isl_map_pipeline_project_out(
+	__isl_take isl_map_pipeline *pipeline,
+	enum isl_dim_type type, unsigned first, unsigned n)
+{
+	isl_map **map;
+
+	pipeline = isl_map_pipeline_cow(pipeline);
+	if (!pipeline)
+		return NULL;
+
+	if (type == isl_dim_in) {
+		map = &pipeline->map;
+	} else if (type == isl_dim_out) {
+		map = pipeline_last(pipeline);
+	} else {
+		pipeline = pipeline_compose(pipeline);
+		if (!pipeline)
+			return NULL;
+		map = &pipeline->map;
+	}
+
+	*map = isl_map_project_out(*map, type, first, n);
+	if (!*map)
+		return isl_map_pipeline_free(pipeline);
+
+	return pipeline;
+}
+
+/* Mark the result represented by "pipeline" for coalescing.
+ * The coalescing itself is performed by isl_map_pipeline_evaluate.
+ */
+__isl_give isl_map_pipeline *isl_map_pipeline_coalesce(
+	__isl_take isl_map_pipeline *pipeline)
+{
+	if (!pipeline)
+		return NULL;
+	if (pipeline->coalesce)
+		return pipeline;
+
+	pipeline = isl_map_pipeline_cow(pipeline);
+	if (!pipeline)
+		return NULL;
+
+	pipeline->coalesce = 1;
+
+	return pipeline;
+}
+
+/* Compute the result represented by "pipeline".
+ */
+__isl_give isl_map *isl_map_pipeline_evaluate(
+	__isl_take isl_map_pipeline *pipeline)
+{
+	isl_map *map;
+
+	pipeline = pipeline_compose(pipeline);
+	if (!pipeline)
+		return NULL;
+
+	if (pipeline->ref == 1) {
+		map = pipeline->map;
+		pipeline->map = NULL;
+	} else {
+		map = isl_map_copy(pipeline->map);
+	}
+	if (pipeline->coalesce)
+		map = isl_map_coalesce(map);
+	isl_map_pipeline_free(pipeline);
+
+	return map;
+}
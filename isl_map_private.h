@@ -528,4 +528,43 @@ int isl_basic_set_count_upto(__isl_keep isl_basic_set *bset,
 	isl_int max, isl_int *count);
 int isl_set_count_upto(__isl_keep isl_set *set, isl_int max, isl_int *count);
 
+/* The possible outcomes of a check whether two basic maps intersect,
+ * performed by isl_basic_map_check_intersections.
+ */
+enum isl_intersect_type {
+	isl_intersect_empty,
+	isl_intersect_non_empty,
+	isl_intersect_unknown
+};
+
+/* Bounds on the variables of a basic map, used to quickly
+ * detect pairs of basic maps that cannot have any element in common.
+ *
+ * "bound" holds a lower bound (at position 2 * k) and an upper bound
+ * (at position 2 * k + 1) on variable k and "bounded" keeps track
+ * of which of these bounds are available.
+ * "bound" is NULL if no bounds have been computed.
+ * "empty" is set if the basic map is known to be empty.
+ */
+struct isl_map_box {
+	int empty;
+	isl_vec *bound;
+	int *bounded;
+};
+
+isl_stat isl_map_box_alloc(struct isl_map_box *box, isl_ctx *ctx,
+	unsigned dim);
+void isl_map_box_clear(struct isl_map_box *box);
+void isl_map_box_update(struct isl_map_box *box, int pos, int upper,
+	isl_int v);
+void isl_map_box_add_constraint(struct isl_map_box *box, isl_int *c,
+	int eq, unsigned total, unsigned dim, int unit);
+struct isl_map_box *isl_map_boxes(__isl_keep isl_map *map);
+void isl_map_boxes_free(struct isl_map_box *boxes, int n);
+
+isl_bool isl_basic_map_plain_is_box_disjoint(__isl_keep isl_basic_map *bmap,
+	__isl_keep isl_map *map, struct isl_map_box *boxes);
+isl_stat isl_basic_map_check_intersections(__isl_keep isl_basic_map *bmap,
+	__isl_keep isl_map *map, enum isl_intersect_type *type);
+
 #endif
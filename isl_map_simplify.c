@@ -13,6 +13,7 @@
  * B.P. 105 - 78153 Le Chesnay, France
  */
 
+#include <string.h>
 #include <isl_ctx_private.h>
 #include <isl_map_private.h>
 #include "isl_equalities.h"
@@ -471,20 +472,21 @@ static __isl_give isl_basic_map *remove_independent_vars_from_divs(
 static void normalize_div_expression(__isl_keep isl_basic_map *bmap, int div)
 {
 	unsigned total = isl_basic_map_total_dim(bmap);
+	isl_int local, *gcd;
 	isl_ctx *ctx = bmap->ctx;
 
 	if (isl_int_is_zero(bmap->div[div][0]))
 		return;
-	isl_seq_gcd(bmap->div[div] + 2, total, &ctx->normalize_gcd);
-	isl_int_gcd(ctx->normalize_gcd, ctx->normalize_gcd, bmap->div[div][0]);
-	if (isl_int_is_one(ctx->normalize_gcd))
-		return;
-	isl_int_fdiv_q(bmap->div[div][1], bmap->div[div][1],
-			ctx->normalize_gcd);
-	isl_int_divexact(bmap->div[div][0], bmap->div[div][0],
-			ctx->normalize_gcd);
-	isl_seq_scale_down(bmap->div[div] + 2, bmap->div[div] + 2,
-			ctx->normalize_gcd, total);
+	gcd = isl_ctx_get_normalize_gcd(ctx, &local);
+	isl_seq_gcd(bmap->div[div] + 2, total, gcd);
+	isl_int_gcd(*gcd, *gcd, bmap->div[div][0]);
+	if (!isl_int_is_one(*gcd)) {
+		isl_int_fdiv_q(bmap->div[div][1], bmap->div[div][1], *gcd);
+		isl_int_divexact(bmap->div[div][0], bmap->div[div][0], *gcd);
+		isl_seq_scale_down(bmap->div[div] + 2, bmap->div[div] + 2,
+				*gcd, total);
+	}
+	isl_ctx_release_normalize_gcd(ctx, gcd);
 }
 
 /* Remove any common factor in numerator and denominator of a div expression,
@@ -1303,6 +1305,97 @@ static struct isl_basic_map *check_for_div_constraints(
 	return bmap;
 }
 
+/* The minimal number of inequalities for which
+ * isl_basic_map_remove_duplicate_constraints computes support bitmaps.
+ * For fewer inequalities, the allocations and the sort cost more
+ * than the negations and rehashes they save.
+ */
+#define MIN_INEQ_FOR_SUPPORT	16
+
+/* Return a bitmap of the positions of the non-zero elements of "p"
+ * of length "len", where position i is mapped to bit i modulo 64.
+ * Two sequences that are equal or opposite to each other
+ * have the same support bitmap.
+ */
+static uint64_t seq_support(isl_int *p, unsigned len)
+{
+	int i;
+	uint64_t support = 0;
+
+	for (i = 0; i < len; ++i)
+		if (!isl_int_is_zero(p[i]))
+			support |= (uint64_t) 1 << (i % 64);
+
+	return support;
+}
+
+static int cmp_support(const void *p1, const void *p2)
+{
+	uint64_t s1 = *(const uint64_t *) p1;
+	uint64_t s2 = *(const uint64_t *) p2;
+
+	return s1 < s2 ? -1 : s1 > s2 ? 1 : 0;
+}
+
+/* Compute the support bitmaps of the coefficients (excluding
+ * the constant term) of the inequalities of "bmap" in "support" and
+ * store a sorted copy in "sorted".
+ * Return -1 on error.
+ */
+static int compute_ineq_supports(__isl_keep isl_basic_map *bmap,
+	uint64_t **support, uint64_t **sorted)
+{
+	int k;
+	unsigned total = isl_basic_map_total_dim(bmap);
+	isl_ctx *ctx = isl_basic_map_get_ctx(bmap);
+
+	*support = isl_alloc_array(ctx, uint64_t, bmap->n_ineq);
+	*sorted = isl_alloc_array(ctx, uint64_t, bmap->n_ineq);
+	if (!*support || !*sorted) {
+		free(*support);
+		free(*sorted);
+		*support = *sorted = NULL;
+		return -1;
+	}
+	for (k = 0; k < bmap->n_ineq; ++k)
+		(*support)[k] = (*sorted)[k] =
+				seq_support(bmap->ineq[k] + 1, total);
+	qsort(*sorted, bmap->n_ineq, sizeof(uint64_t), &cmp_support);
+
+	return 0;
+}
+
+/* Does "support" appear at least twice in the sorted array "sorted"
+ * of length "n"?
+ * Since "support" is known to appear at least once,
+ * it is enough to check the neighbors of any occurrence.
+ */
+static int support_is_shared(uint64_t *sorted, int n, uint64_t support)
+{
+	uint64_t *pos;
+	int i;
+
+	pos = bsearch(&support, sorted, n, sizeof(uint64_t), &cmp_support);
+	if (!pos)
+		return 1;
+	i = pos - sorted;
+	return (i > 0 && sorted[i - 1] == support) ||
+		(i + 1 < n && sorted[i + 1] == support);
+}
+
+/* Remove duplicate inequalities from "bmap", keeping only
+ * the tightest of each group of inequalities that are equal
+ * up to the constant term, and detect pairs of opposite inequalities.
+ *
+ * An inequality can only be opposite to another inequality if
+ * they involve the same variables.  The support bitmaps of
+ * the inequalities are therefore computed first, such that
+ * inequalities with a unique support bitmap can be skipped
+ * in the search for opposite inequalities without having to
+ * negate and rehash their coefficients.
+ * This is only done if there are at least MIN_INEQ_FOR_SUPPORT
+ * inequalities left after removing the duplicates.
+ */
 __isl_give isl_basic_map *isl_basic_map_remove_duplicate_constraints(
 	__isl_take isl_basic_map *bmap, int *progress, int detect_divs)
 {
@@ -1310,6 +1403,7 @@ __isl_give isl_basic_map *isl_basic_map_remove_duplicate_constraints(
 	int k, l, h;
 	unsigned total = isl_basic_map_total_dim(bmap);
 	isl_int sum;
+	uint64_t *support = NULL, *sorted = NULL;
 
 	if (!bmap || bmap->n_ineq <= 1)
 		return bmap;
@@ -1333,8 +1427,14 @@ __isl_give isl_basic_map *isl_basic_map_remove_duplicate_constraints(
 		isl_basic_map_drop_inequality(bmap, k);
 		--k;
 	}
+	if (bmap->n_ineq >= MIN_INEQ_FOR_SUPPORT &&
+	    compute_ineq_supports(bmap, &support, &sorted) < 0)
+		support = sorted = NULL;
 	isl_int_init(sum);
 	for (k = 0; k < bmap->n_ineq-1; ++k) {
+		if (support &&
+		    !support_is_shared(sorted, bmap->n_ineq, support[k]))
+			continue;
 		isl_seq_neg(bmap->ineq[k]+1, bmap->ineq[k]+1, total);
 		h = hash_index(&ci, bmap, k);
 		isl_seq_neg(bmap->ineq[k]+1, bmap->ineq[k]+1, total);
@@ -1363,6 +1463,8 @@ __isl_give isl_basic_map *isl_basic_map_remove_duplicate_constraints(
 		break;
 	}
 	isl_int_clear(sum);
+	free(support);
+	free(sorted);
 
 	constraint_index_free(&ci);
 	return bmap;
@@ -1702,16 +1804,365 @@ static struct isl_basic_map *remove_dependent_vars(struct isl_basic_map *bmap,
 	return bmap;
 }
 
+/* Collect the positions of the inequalities of "bmap" that involve
+ * the variable at position "pos" in "index", in increasing order,
+ * and count the number of lower and upper bounds on this variable
+ * in "n_lower" and "n_upper".
+ * "index" is assumed to have room for bmap->n_ineq elements.
+ *
+ * Since the constraints are stored in a single block with fixed stride,
+ * this only walks down a single column of that block.
+ */
+static int collect_ineq_column(__isl_keep isl_basic_map *bmap, unsigned pos,
+	int *index, int *n_lower, int *n_upper)
+{
+	int i, n;
+
+	n = 0;
+	*n_lower = 0;
+	*n_upper = 0;
+	for (i = 0; i < bmap->n_ineq; ++i) {
+		int sgn = isl_int_sgn(bmap->ineq[i][1 + pos]);
+
+		if (sgn == 0)
+			continue;
+		if (sgn > 0)
+			(*n_lower)++;
+		else
+			(*n_upper)++;
+		index[n++] = i;
+	}
+
+	return n;
+}
+
+/* The number of bits in a word of a bit vector in struct isl_fm_history.
+ */
+#define FM_WORD_BITS	(8 * sizeof(unsigned long))
+
+/* The history of the inequality constraints of a basic map
+ * during a sequence of Fourier-Motzkin elimination steps,
+ * starting from the "n_orig" inequality constraints
+ * the basic map has at the start of the sequence.
+ * "n_elim" is the number of variables eliminated in the sequence so far.
+ *
+ * For each inequality constraint, "hist" keeps track of the set
+ * of original constraints from which it was derived and
+ * "vars" keeps track of the set of variables that appear
+ * in any of those original constraints.
+ * These sets are represented by bit vectors of "h_len" and "v_len" words.
+ * "rounded" is set for inequality constraints that are not
+ * a non-negative combination of the original constraints because
+ * the constant term of the constraint or that of one of
+ * the constraints from which it was derived was rounded down.
+ * "size" is the number of inequality constraints for which
+ * room has been allocated.
+ */
+struct isl_fm_history {
+	int n_orig;
+	int n_elim;
+	int size;
+	int h_len;
+	int v_len;
+	unsigned long *hist;
+	unsigned long *vars;
+	int *rounded;
+};
+
+/* Free the memory allocated for "hist".
+ */
+static void fm_history_clear(struct isl_fm_history *hist)
+{
+	free(hist->hist);
+	free(hist->vars);
+	free(hist->rounded);
+	hist->hist = NULL;
+	hist->vars = NULL;
+	hist->rounded = NULL;
+	hist->size = 0;
+}
+
+/* Make sure "hist" has room for "n" inequality constraints.
+ */
+static isl_stat fm_history_extend(isl_ctx *ctx, struct isl_fm_history *hist,
+	int n)
+{
+	unsigned long *h, *v;
+	int *r;
+
+	if (n <= hist->size)
+		return isl_stat_ok;
+
+	h = isl_realloc_array(ctx, hist->hist, unsigned long, n * hist->h_len);
+	if (h)
+		hist->hist = h;
+	v = isl_realloc_array(ctx, hist->vars, unsigned long, n * hist->v_len);
+	if (v)
+		hist->vars = v;
+	r = isl_realloc_array(ctx, hist->rounded, int, n);
+	if (r)
+		hist->rounded = r;
+	if ((hist->h_len && !h) || (hist->v_len && !v) || !r)
+		return isl_stat_error;
+	hist->size = n;
+
+	return isl_stat_ok;
+}
+
+/* Start a new sequence of Fourier-Motzkin elimination steps in "hist",
+ * with the current inequality constraints of "bmap"
+ * as original constraints.
+ */
+static isl_stat fm_history_init(__isl_keep isl_basic_map *bmap,
+	struct isl_fm_history *hist)
+{
+	int i, pos;
+	unsigned total;
+
+	fm_history_clear(hist);
+	total = isl_basic_map_total_dim(bmap);
+	hist->n_orig = bmap->n_ineq;
+	hist->n_elim = 0;
+	hist->h_len = (bmap->n_ineq + FM_WORD_BITS - 1) / FM_WORD_BITS;
+	hist->v_len = (total + FM_WORD_BITS - 1) / FM_WORD_BITS;
+	if (fm_history_extend(bmap->ctx, hist, bmap->n_ineq) < 0)
+		return isl_stat_error;
+
+	for (i = 0; i < bmap->n_ineq; ++i) {
+		unsigned long *h = hist->hist + i * hist->h_len;
+		unsigned long *v = hist->vars + i * hist->v_len;
+
+		memset(h, 0, hist->h_len * sizeof(unsigned long));
+		memset(v, 0, hist->v_len * sizeof(unsigned long));
+		h[i / FM_WORD_BITS] |= 1UL << (i % FM_WORD_BITS);
+		hist->rounded[i] = 0;
+		for (pos = 0; pos < total; ++pos)
+			if (!isl_int_is_zero(bmap->ineq[i][1 + pos]))
+				v[pos / FM_WORD_BITS] |=
+					1UL << (pos % FM_WORD_BITS);
+	}
+
+	return isl_stat_ok;
+}
+
+/* Copy the history of inequality constraint "src" to that of "dst".
+ */
+static void fm_history_move(struct isl_fm_history *hist, int dst, int src)
+{
+	memcpy(hist->hist + dst * hist->h_len, hist->hist + src * hist->h_len,
+		hist->h_len * sizeof(unsigned long));
+	memcpy(hist->vars + dst * hist->v_len, hist->vars + src * hist->v_len,
+		hist->v_len * sizeof(unsigned long));
+	hist->rounded[dst] = hist->rounded[src];
+}
+
+/* Return the number of elements in the set represented
+ * by the bit vector "v" of "len" words.
+ */
+static int fm_bits_count(unsigned long *v, int len)
+{
+	int i, n = 0;
+
+	for (i = 0; i < len; ++i) {
+		unsigned long w;
+
+		for (w = v[i]; w; w &= w - 1)
+			n++;
+	}
+
+	return n;
+}
+
+/* Set the history of inequality constraint "k" of "bmap",
+ * which is a combination of inequality constraints "i" and "j",
+ * to the union of their histories and check whether
+ * it is worth keeping.
+ * "rounded" is set if the constant term of the constraint
+ * was rounded down during its normalization.
+ *
+ * The constraint is redundant if it was derived from more than
+ * 1 + n_elim original constraints (Chernikov) or
+ * from more than 1 + m original constraints, with m the number
+ * of variables that appear in any of those original constraints,
+ * but not in the combination (Imbert).
+ * The latter set of variables consists of the variables that were
+ * eliminated in the derivation of the constraint as well as
+ * those that got eliminated implicitly.
+ * These results only hold for non-negative combinations of
+ * the original constraints, so constraints that involve rounding
+ * are always kept.
+ */
+static int fm_history_combine(__isl_keep isl_basic_map *bmap,
+	struct isl_fm_history *hist, int k, int i, int j, int rounded)
+{
+	int l, pos, n_hist, n_gone;
+	unsigned total;
+	unsigned long *h = hist->hist + k * hist->h_len;
+	unsigned long *v = hist->vars + k * hist->v_len;
+
+	for (l = 0; l < hist->h_len; ++l)
+		h[l] = hist->hist[i * hist->h_len + l] |
+			hist->hist[j * hist->h_len + l];
+	for (l = 0; l < hist->v_len; ++l)
+		v[l] = hist->vars[i * hist->v_len + l] |
+			hist->vars[j * hist->v_len + l];
+	hist->rounded[k] = rounded || hist->rounded[i] || hist->rounded[j];
+	if (hist->rounded[k])
+		return 1;
+
+	n_hist = fm_bits_count(h, hist->h_len);
+	if (n_hist > 1 + hist->n_elim)
+		return 0;
+
+	total = isl_basic_map_total_dim(bmap);
+	n_gone = 0;
+	for (pos = 0; pos < total; ++pos) {
+		if (!(v[pos / FM_WORD_BITS] & (1UL << (pos % FM_WORD_BITS))))
+			continue;
+		if (isl_int_is_zero(bmap->ineq[k][1 + pos]))
+			n_gone++;
+	}
+
+	return n_hist <= 1 + n_gone;
+}
+
+/* Add the combination of inequality constraints "i" and "j" of "bmap"
+ * that eliminates the variable at position "d", unless it is
+ * redundant according to the history "hist".
+ * "gcd" is a temporary variable.
+ *
+ * The combination is normalized in the same way as
+ * in isl_basic_map_normalize_constraints.
+ * If it no longer involves any variables, then it is either trivially
+ * satisfied, in which case it is not added, or it is a contradiction,
+ * in which case "bmap" is empty.
+ */
+static __isl_give isl_basic_map *fm_add_combination(
+	__isl_take isl_basic_map *bmap, unsigned d, int i, int j,
+	struct isl_fm_history *hist, isl_int *gcd)
+{
+	int k;
+	int rounded = 0;
+	unsigned total;
+	isl_int *c;
+
+	total = isl_basic_map_total_dim(bmap);
+	k = isl_basic_map_alloc_inequality(bmap);
+	if (k < 0)
+		return isl_basic_map_free(bmap);
+	c = bmap->ineq[k];
+	isl_seq_cpy(c, bmap->ineq[i], 1 + total);
+	isl_seq_elim(c, bmap->ineq[j], 1 + d, 1 + total, NULL);
+
+	isl_seq_gcd(c + 1, total, gcd);
+	if (isl_int_is_zero(*gcd)) {
+		int infeasible = isl_int_is_neg(c[0]);
+		isl_basic_map_free_inequality(bmap, 1);
+		if (infeasible)
+			bmap = isl_basic_map_set_to_empty(bmap);
+		return bmap;
+	}
+	if (ISL_F_ISSET(bmap, ISL_BASIC_MAP_RATIONAL))
+		isl_int_gcd(*gcd, *gcd, c[0]);
+	if (!isl_int_is_one(*gcd)) {
+		rounded = !isl_int_is_divisible_by(c[0], *gcd);
+		isl_int_fdiv_q(c[0], c[0], *gcd);
+		isl_seq_scale_down(c + 1, c + 1, *gcd, total);
+	}
+
+	if (!fm_history_combine(bmap, hist, k, i, j, rounded))
+		isl_basic_map_free_inequality(bmap, 1);
+
+	return bmap;
+}
+
+/* Eliminate the variable at position "d" from the inequalities of "bmap"
+ * using Fourier-Motzkin, given the positions "index" of the "n"
+ * inequalities that involve the variable, in increasing order.
+ * "hist" keeps track of the history of the inequalities and
+ * is assumed to have room for all combinations.
+ *
+ * The inequalities are handled from last to first.
+ * Each of them is combined with every earlier inequality of opposite sign
+ * and then dropped.  Since dropping an inequality only moves
+ * the last inequality into its position and since all later inequalities
+ * that involve the variable have already been dropped,
+ * the positions in "index" of earlier inequalities remain valid.
+ * Only the pairs of inequalities that actually involve the variable
+ * are visited and combinations that are known to be redundant
+ * based on their history are not added.
+ */
+static __isl_give isl_basic_map *fm_eliminate_var(
+	__isl_take isl_basic_map *bmap, unsigned d, int *index, int n,
+	struct isl_fm_history *hist)
+{
+	int a, b;
+	isl_int gcd;
+
+	hist->n_elim++;
+	isl_int_init(gcd);
+	for (a = n - 1; bmap && a >= 0; --a) {
+		int i = index[a];
+
+		for (b = 0; bmap && b < a; ++b) {
+			int j = index[b];
+
+			if (isl_int_sgn(bmap->ineq[i][1 + d]) ==
+			    isl_int_sgn(bmap->ineq[j][1 + d]))
+				continue;
+			bmap = fm_add_combination(bmap, d, i, j, hist, &gcd);
+			if (bmap && ISL_F_ISSET(bmap, ISL_BASIC_MAP_EMPTY))
+				break;
+		}
+		if (!bmap || ISL_F_ISSET(bmap, ISL_BASIC_MAP_EMPTY))
+			break;
+		isl_basic_map_drop_inequality(bmap, i);
+		if (i != bmap->n_ineq)
+			fm_history_move(hist, i, bmap->n_ineq);
+	}
+	isl_int_clear(gcd);
+
+	return bmap;
+}
+
+/* Remove duplicate and redundant inequality constraints from "bmap"
+ * after some Fourier-Motzkin elimination steps.
+ */
+static __isl_give isl_basic_map *fm_remove_redundancies(
+	__isl_take isl_basic_map *bmap)
+{
+	bmap = isl_basic_map_normalize_constraints(bmap);
+	bmap = isl_basic_map_remove_duplicate_constraints(bmap, NULL, 0);
+	bmap = isl_basic_map_gauss(bmap, NULL);
+	bmap = isl_basic_map_remove_redundancies(bmap);
+	return bmap;
+}
+
 /* Eliminate the specified variables from the constraints using
  * Fourier-Motzkin.  The variables themselves are not removed.
+ *
+ * The history of the inequality constraints is tracked
+ * during a sequence of elimination steps such that combinations
+ * that are known to be redundant can be dropped immediately.
+ * The (more expensive) removal of other redundant constraints
+ * is only performed at the end or when the number of constraints
+ * has doubled since the start of the sequence.
+ * Since this removal may drop constraints that are needed to derive
+ * non-redundant combinations in subsequent steps, a new sequence
+ * is started afterwards.  The same holds after the elimination
+ * of a variable using an equality constraint.
  */
 struct isl_basic_map *isl_basic_map_eliminate_vars(
 	struct isl_basic_map *bmap, unsigned pos, unsigned n)
 {
 	int d;
-	int i, j, k;
+	int i;
 	unsigned total;
 	int need_gauss = 0;
+	int need_redundancy_removal = 0;
+	int new_sequence = 1;
+	int *index;
+	struct isl_fm_history hist = { 0 };
 
 	if (n == 0)
 		return bmap;
@@ -1729,72 +2180,68 @@ struct isl_basic_map *isl_basic_map_eliminate_vars(
 	     d >= 0 && d >= total - bmap->n_div && d >= pos; --d)
 		isl_seq_clr(bmap->div[d-(total-bmap->n_div)], 2+total);
 	for (d = pos + n - 1; d >= 0 && d >= pos; --d) {
-		int n_lower, n_upper;
+		int n_lower, n_upper, n_index;
 		if (!bmap)
-			return NULL;
+			goto error;
 		for (i = 0; i < bmap->n_eq; ++i) {
 			if (isl_int_is_zero(bmap->eq[i][1+d]))
 				continue;
 			eliminate_var_using_equality(bmap, d, bmap->eq[i], 0, NULL);
 			isl_basic_map_drop_equality(bmap, i);
 			need_gauss = 1;
+			new_sequence = 1;
 			break;
 		}
 		if (i < bmap->n_eq)
 			continue;
-		n_lower = 0;
-		n_upper = 0;
-		for (i = 0; i < bmap->n_ineq; ++i) {
-			if (isl_int_is_pos(bmap->ineq[i][1+d]))
-				n_lower++;
-			else if (isl_int_is_neg(bmap->ineq[i][1+d]))
-				n_upper++;
-		}
+		if (new_sequence && fm_history_init(bmap, &hist) < 0)
+			goto error;
+		new_sequence = 0;
+		index = isl_alloc_array(bmap->ctx, int, bmap->n_ineq);
+		if (bmap->n_ineq && !index)
+			goto error;
+		n_index = collect_ineq_column(bmap, d, index,
+						&n_lower, &n_upper);
 		bmap = isl_basic_map_extend_constraints(bmap,
 				0, n_lower * n_upper);
+		if (bmap && fm_history_extend(bmap->ctx, &hist,
+				    bmap->n_ineq + n_lower * n_upper) < 0)
+			bmap = isl_basic_map_free(bmap);
+		if (bmap)
+			bmap = fm_eliminate_var(bmap, d, index, n_index, &hist);
+		free(index);
 		if (!bmap)
 			goto error;
-		for (i = bmap->n_ineq - 1; i >= 0; --i) {
-			int last;
-			if (isl_int_is_zero(bmap->ineq[i][1+d]))
-				continue;
-			last = -1;
-			for (j = 0; j < i; ++j) {
-				if (isl_int_is_zero(bmap->ineq[j][1+d]))
-					continue;
-				last = j;
-				if (isl_int_sgn(bmap->ineq[i][1+d]) ==
-				    isl_int_sgn(bmap->ineq[j][1+d]))
-					continue;
-				k = isl_basic_map_alloc_inequality(bmap);
-				if (k < 0)
-					goto error;
-				isl_seq_cpy(bmap->ineq[k], bmap->ineq[i],
-						1+total);
-				isl_seq_elim(bmap->ineq[k], bmap->ineq[j],
-						1+d, 1+total, NULL);
-			}
-			isl_basic_map_drop_inequality(bmap, i);
-			i = last + 1;
-		}
-		if (n_lower > 0 && n_upper > 0) {
-			bmap = isl_basic_map_normalize_constraints(bmap);
-			bmap = isl_basic_map_remove_duplicate_constraints(bmap,
-								    NULL, 0);
-			bmap = isl_basic_map_gauss(bmap, NULL);
-			bmap = isl_basic_map_remove_redundancies(bmap);
+		if (ISL_F_ISSET(bmap, ISL_BASIC_MAP_EMPTY))
+			break;
+		if (n_lower > 0 && n_upper > 0)
+			need_redundancy_removal = 1;
+		if (need_redundancy_removal &&
+		    bmap->n_ineq > 2 * hist.n_orig) {
+			bmap = fm_remove_redundancies(bmap);
 			need_gauss = 0;
+			need_redundancy_removal = 0;
+			new_sequence = 1;
 			if (!bmap)
 				goto error;
 			if (ISL_F_ISSET(bmap, ISL_BASIC_MAP_EMPTY))
 				break;
 		}
 	}
+	fm_history_clear(&hist);
+	if (need_redundancy_removal &&
+	    !ISL_F_ISSET(bmap, ISL_BASIC_MAP_EMPTY)) {
+		bmap = fm_remove_redundancies(bmap);
+		need_gauss = 0;
+	}
+	if (!bmap)
+		return NULL;
 	ISL_F_CLR(bmap, ISL_BASIC_MAP_NORMALIZED);
 	if (need_gauss)
 		bmap = isl_basic_map_gauss(bmap, NULL);
 	return bmap;
 error:
+	fm_history_clear(&hist);
 	isl_basic_map_free(bmap);
 	return NULL;
 }
@@ -2657,10 +3104,9 @@ static __isl_give isl_basic_set *uset_gist_compressed(
 	__isl_take isl_basic_set *bset, __isl_take isl_basic_set *context,
 	__isl_take isl_mat *T)
 {
-	isl_ctx *ctx;
 	isl_mat *ineq;
 	int i, n_row, n_col;
-	isl_int rem;
+	isl_int rem, gcd;
 
 	ineq = extract_ineq(bset);
 	ineq = isl_mat_product(ineq, isl_mat_copy(T));
@@ -2674,21 +3120,20 @@ static __isl_give isl_basic_set *uset_gist_compressed(
 		return isl_basic_set_set_to_empty(bset);
 	}
 
-	ctx = isl_mat_get_ctx(ineq);
 	n_row = isl_mat_rows(ineq);
 	n_col = isl_mat_cols(ineq);
 	isl_int_init(rem);
+	isl_int_init(gcd);
 	for (i = 0; i < n_row; ++i) {
-		isl_seq_gcd(ineq->row[i] + 1, n_col - 1, &ctx->normalize_gcd);
-		if (isl_int_is_zero(ctx->normalize_gcd))
+		isl_seq_gcd(ineq->row[i] + 1, n_col - 1, &gcd);
+		if (isl_int_is_zero(gcd))
 			continue;
-		if (isl_int_is_one(ctx->normalize_gcd))
+		if (isl_int_is_one(gcd))
 			continue;
 		isl_seq_scale_down(ineq->row[i] + 1, ineq->row[i] + 1,
-				    ctx->normalize_gcd, n_col - 1);
-		isl_int_fdiv_r(rem, ineq->row[i][0], ctx->normalize_gcd);
-		isl_int_fdiv_q(ineq->row[i][0],
-				ineq->row[i][0], ctx->normalize_gcd);
+				    gcd, n_col - 1);
+		isl_int_fdiv_r(rem, ineq->row[i][0], gcd);
+		isl_int_fdiv_q(ineq->row[i][0], ineq->row[i][0], gcd);
 		if (isl_int_is_zero(rem))
 			continue;
 		bset = isl_basic_set_cow(bset);
@@ -2697,6 +3142,7 @@ static __isl_give isl_basic_set *uset_gist_compressed(
 		isl_int_sub(bset->ineq[i][0], bset->ineq[i][0], rem);
 	}
 	isl_int_clear(rem);
+	isl_int_clear(gcd);
 
 	return uset_gist_full(bset, ineq, context);
 error:
@@ -3815,6 +4261,55 @@ static isl_bool all_pairs(__isl_keep isl_map *map1, __isl_keep isl_map *map2,
 	return isl_bool_true;
 }
 
+/* Are all pairs of basic maps in "map1" and "map2" disjoint?
+ *
+ * If "map2" consists of several basic maps, then first check
+ * for each basic map in "map1" which of the basic maps in "map2"
+ * it intersects using a single tableau.
+ * Only the pairs for which this check is inconclusive are passed
+ * to isl_basic_map_is_disjoint.
+ */
+static isl_bool all_pairs_disjoint(__isl_keep isl_map *map1,
+	__isl_keep isl_map *map2)
+{
+	int i, j;
+	enum isl_intersect_type *type;
+	isl_bool disjoint = isl_bool_true;
+
+	if (!map1 || !map2)
+		return isl_bool_error;
+	if (map2->n < 2)
+		return all_pairs(map1, map2, &isl_basic_map_is_disjoint);
+
+	type = isl_alloc_array(map1->ctx, enum isl_intersect_type, map2->n);
+	if (!type)
+		return isl_bool_error;
+
+	for (i = 0; disjoint == isl_bool_true && i < map1->n; ++i) {
+		for (j = 0; j < map2->n; ++j)
+			type[j] = isl_intersect_unknown;
+		if (isl_basic_map_check_intersections(map1->p[i], map2,
+							type) < 0) {
+			disjoint = isl_bool_error;
+			break;
+		}
+		for (j = 0; j < map2->n; ++j) {
+			if (type[j] == isl_intersect_empty)
+				continue;
+			if (type[j] == isl_intersect_non_empty)
+				disjoint = isl_bool_false;
+			else
+				disjoint = isl_basic_map_is_disjoint(map1->p[i],
+								map2->p[j]);
+			if (disjoint != isl_bool_true)
+				break;
+		}
+	}
+
+	free(type);
+	return disjoint;
+}
+
 /* Are "map1" and "map2" obviously disjoint, based on information
  * that can be derived without looking at the individual basic maps?
  *
@@ -3926,7 +4421,7 @@ isl_bool isl_map_is_disjoint(__isl_keep isl_map *map1, __isl_keep isl_map *map2)
 	if (intersect < 0 || intersect)
 		return isl_bool_not(intersect);
 
-	return all_pairs(map1, map2, &isl_basic_map_is_disjoint);
+	return all_pairs_disjoint(map1, map2);
 }
 
 /* Are "bmap1" and "bmap2" disjoint?
@@ -5173,24 +5668,26 @@ static int has_multiple_var_equality(__isl_keep isl_basic_map *bmap)
 static __isl_give isl_vec *normalize_constraint(__isl_take isl_vec *v,
 	int *tightened)
 {
+	isl_int local, *gcd;
 	isl_ctx *ctx;
 
 	if (!v)
 		return NULL;
 	ctx = isl_vec_get_ctx(v);
-	isl_seq_gcd(v->el + 1, v->size - 1, &ctx->normalize_gcd);
-	if (isl_int_is_zero(ctx->normalize_gcd))
-		return v;
-	if (isl_int_is_one(ctx->normalize_gcd))
+	gcd = isl_ctx_get_normalize_gcd(ctx, &local);
+	isl_seq_gcd(v->el + 1, v->size - 1, gcd);
+	if (isl_int_is_zero(*gcd) || isl_int_is_one(*gcd)) {
+		isl_ctx_release_normalize_gcd(ctx, gcd);
 		return v;
+	}
 	v = isl_vec_cow(v);
-	if (!v)
-		return NULL;
-	if (tightened && !isl_int_is_divisible_by(v->el[0], ctx->normalize_gcd))
-		*tightened = 1;
-	isl_int_fdiv_q(v->el[0], v->el[0], ctx->normalize_gcd);
-	isl_seq_scale_down(v->el + 1, v->el + 1, ctx->normalize_gcd,
-				v->size - 1);
+	if (v) {
+		if (tightened && !isl_int_is_divisible_by(v->el[0], *gcd))
+			*tightened = 1;
+		isl_int_fdiv_q(v->el[0], v->el[0], *gcd);
+		isl_seq_scale_down(v->el + 1, v->el + 1, *gcd, v->size - 1);
+	}
+	isl_ctx_release_normalize_gcd(ctx, gcd);
 	return v;
 }
 
@@ -7,7 +7,9 @@
  * Computerwetenschappen, Celestijnenlaan 200A, B-3001 Leuven, Belgium
  */
 
+#include <isl_ctx_private.h>
 #include <isl_map_private.h>
+#include <isl_options_private.h>
 #include <isl_seq.h>
 #include <isl/set.h>
 #include <isl/map.h>
@@ -256,6 +258,81 @@ static int n_non_redundant(isl_ctx *ctx, struct isl_tab *tab,
 	return n;
 }
 
+/* Add the basic map "bmap", which is assumed to have known divs,
+ * to the tableau "tab" and check what this tells us about
+ * the intersection of "bmap" with the basic map represented by "tab".
+ * "tab" is rolled back to its original state afterwards.
+ *
+ * If the tableau becomes (rationally) empty, then so is the intersection.
+ * If the sample value of the tableau is integral, then it is
+ * an element of the intersection.
+ * Otherwise, no conclusion can be drawn.
+ */
+static isl_stat tab_check_intersection(struct isl_tab *tab,
+	__isl_keep isl_basic_map *bmap, enum isl_intersect_type *type)
+{
+	int r;
+	int integer;
+	int *div_map = NULL;
+	struct isl_tab_undo *snap;
+
+	bmap = isl_basic_map_order_divs(isl_basic_map_copy(bmap));
+	if (!bmap)
+		return isl_stat_error;
+
+	snap = isl_tab_snap(tab);
+	r = tab_add_divs(tab, bmap, &div_map);
+	if (r >= 0)
+		r = tab_add_constraints(tab, bmap, div_map);
+	free(div_map);
+	isl_basic_map_free(bmap);
+	if (r < 0)
+		return isl_stat_error;
+
+	if (tab->empty) {
+		*type = isl_intersect_empty;
+	} else {
+		integer = isl_tab_sample_is_integer(tab);
+		if (integer < 0)
+			return isl_stat_error;
+		*type = integer ? isl_intersect_non_empty :
+				  isl_intersect_unknown;
+	}
+
+	if (isl_tab_rollback(tab, snap) < 0)
+		return isl_stat_error;
+	return isl_stat_ok;
+}
+
+/* Remove the basic maps from "map" that are known not to intersect
+ * the basic map represented by "tab", preserving the order
+ * of the remaining basic maps.
+ * "map" is assumed to have known divs and to be owned by the caller,
+ * such that it can be modified in place.
+ * In case of an error, "map" is left in a consistent state.
+ */
+static isl_stat drop_non_intersecting(__isl_keep isl_map *map,
+	struct isl_tab *tab)
+{
+	int i, n;
+	isl_stat r = isl_stat_ok;
+
+	for (i = n = 0; i < map->n; ++i) {
+		enum isl_intersect_type type = isl_intersect_unknown;
+
+		if (r >= 0)
+			r = tab_check_intersection(tab, map->p[i], &type);
+		if (type == isl_intersect_empty) {
+			isl_basic_map_free(map->p[i]);
+			continue;
+		}
+		map->p[n++] = map->p[i];
+	}
+	map->n = n;
+
+	return r;
+}
+
 /* basic_map_collect_diff calls add on each of the pieces of
  * the set difference between bmap and map until the add method
  * return a negative value.
@@ -274,6 +351,11 @@ struct isl_diff_collector {
  *
  * Assumes that map has known divs.
  *
+ * If "map" consists of several basic maps, then those that do not
+ * intersect "bmap" are removed first.  Otherwise, they would be
+ * checked again in every piece of "bmap" that is constructed
+ * by the algorithm below, while they cannot intersect any of these pieces.
+ *
  * The difference is computed by a backtracking algorithm.
  * Each level corresponds to a basic map in "map".
  * When a node in entered for the first time, we check
@@ -338,6 +420,8 @@ static isl_stat basic_map_collect_diff(__isl_take isl_basic_map *bmap,
 	tab = isl_tab_from_basic_map(bmap, 1);
 	if (!tab)
 		goto error;
+	if (map->n > 1 && drop_non_intersecting(map, tab) < 0)
+		goto error;
 
 	modified = 0;
 	level = 0;
@@ -518,6 +602,10 @@ static __isl_give isl_map *replace_pair_by_empty( __isl_take isl_map *map1,
  * then return an empty map in the same space.
  *
  * If "map1" and "map2" are disjoint, then simply return "map1".
+ *
+ * If the subtract_coalesce option is set, then the difference
+ * of each basic map in "map1" is coalesced before it is added
+ * to the result.
  */
 static __isl_give isl_map *map_subtract( __isl_take isl_map *map1,
 	__isl_take isl_map *map2)
@@ -558,6 +646,8 @@ static __isl_give isl_map *map_subtract( __isl_take isl_map *map1,
 		struct isl_map *d;
 		d = basic_map_subtract(isl_basic_map_copy(map1->p[i]),
 				       isl_map_copy(map2));
+		if (map1->ctx->opt->subtract_coalesce)
+			d = isl_map_coalesce(d);
 		if (ISL_F_ISSET(map1, ISL_MAP_DISJOINT))
 			diff = isl_map_union_disjoint(diff, d);
 		else
@@ -684,27 +774,262 @@ static isl_bool basic_map_diff_is_empty(__isl_keep isl_basic_map *bmap,
 	return r < 0 ? isl_bool_error : isl_bool_true;
 }
 
+/* Does the constraint "sa" * "a" >= 0 imply the constraint "sb" * "b" >= 0,
+ * where "sa" and "sb" are either 1 or -1 and
+ * where "a" and "b" have "len" elements?
+ * This is the case if the linear part of the first constraint
+ * is a positive multiple of that of the second, say lambda times,
+ * and if the constant term of the first is at most lambda times
+ * that of the second.
+ * Constraints that only have a constant term are not considered.
+ */
+static int constraint_implies(isl_int *a, int sa, isl_int *b, int sb,
+	unsigned len)
+{
+	int k, pos, implies;
+	isl_int t1, t2;
+
+	pos = isl_seq_first_non_zero(b + 1, len - 1);
+	if (pos < 0)
+		return 0;
+	if (isl_seq_first_non_zero(a + 1, len - 1) != pos)
+		return 0;
+	if (sa * isl_int_sgn(a[1 + pos]) != sb * isl_int_sgn(b[1 + pos]))
+		return 0;
+
+	isl_int_init(t1);
+	isl_int_init(t2);
+	implies = 1;
+	for (k = 1 + pos + 1; implies && k < len; ++k) {
+		isl_int_mul(t1, a[k], b[1 + pos]);
+		isl_int_mul(t2, b[k], a[1 + pos]);
+		implies = isl_int_eq(t1, t2);
+	}
+	if (implies) {
+		isl_int_mul(t1, a[0], b[1 + pos]);
+		isl_int_mul(t2, b[0], a[1 + pos]);
+		isl_int_abs(t1, t1);
+		isl_int_abs(t2, t2);
+		if (sa * isl_int_sgn(a[0]) < 0)
+			isl_int_neg(t1, t1);
+		if (sb * isl_int_sgn(b[0]) < 0)
+			isl_int_neg(t2, t2);
+		implies = isl_int_le(t1, t2);
+	}
+	isl_int_clear(t2);
+	isl_int_clear(t1);
+
+	return implies;
+}
+
+/* Is the constraint "sign" * "c" >= 0, which only involves
+ * the "dim" non-local variables, implied by a single constraint
+ * of "bmap" that does not involve any local variables?
+ */
+static int plain_is_implied(__isl_keep isl_basic_map *bmap, isl_int *c,
+	int sign, unsigned dim)
+{
+	int j;
+
+	for (j = 0; j < bmap->n_eq; ++j) {
+		if (isl_seq_first_non_zero(bmap->eq[j] + 1 + dim,
+					    bmap->n_div) != -1)
+			continue;
+		if (constraint_implies(bmap->eq[j], 1, c, sign, 1 + dim) ||
+		    constraint_implies(bmap->eq[j], -1, c, sign, 1 + dim))
+			return 1;
+	}
+	for (j = 0; j < bmap->n_ineq; ++j) {
+		if (isl_seq_first_non_zero(bmap->ineq[j] + 1 + dim,
+					    bmap->n_div) != -1)
+			continue;
+		if (constraint_implies(bmap->ineq[j], 1, c, sign, 1 + dim))
+			return 1;
+	}
+
+	return 0;
+}
+
+/* Is "bmap1" obviously a subset of "bmap2"?
+ * That is, is each constraint of "bmap2" implied by a single
+ * constraint of "bmap1"?
+ * Only the case where "bmap2" does not involve any local variables
+ * is considered and an integral "bmap2" may only contain
+ * an integral "bmap1".
+ */
+static int basic_map_plain_is_contained(__isl_keep isl_basic_map *bmap1,
+	__isl_keep isl_basic_map *bmap2)
+{
+	int i;
+	unsigned dim;
+
+	if (bmap2->n_div != 0)
+		return 0;
+	if (ISL_F_ISSET(bmap1, ISL_BASIC_MAP_RATIONAL) &&
+	    !ISL_F_ISSET(bmap2, ISL_BASIC_MAP_RATIONAL))
+		return 0;
+
+	dim = isl_space_dim(bmap2->dim, isl_dim_all);
+	for (i = 0; i < bmap2->n_eq; ++i)
+		if (!plain_is_implied(bmap1, bmap2->eq[i], 1, dim) ||
+		    !plain_is_implied(bmap1, bmap2->eq[i], -1, dim))
+			return 0;
+	for (i = 0; i < bmap2->n_ineq; ++i)
+		if (!plain_is_implied(bmap1, bmap2->ineq[i], 1, dim))
+			return 0;
+
+	return 1;
+}
+
+/* Is "bmap" obviously a subset of "map"?
+ * That is, is "bmap" obviously empty or is it identical to or
+ * obviously a subset of one of the basic maps in "map"?
+ */
+static isl_bool basic_map_plain_is_covered(__isl_keep isl_basic_map *bmap,
+	__isl_keep isl_map *map)
+{
+	int i;
+	isl_bool covered;
+
+	covered = isl_basic_map_plain_is_empty(bmap);
+	if (covered < 0 || covered)
+		return covered;
+
+	for (i = 0; i < map->n; ++i) {
+		covered = isl_basic_map_plain_is_equal(bmap, map->p[i]);
+		if (covered < 0 || covered)
+			return covered;
+		if (basic_map_plain_is_contained(bmap, map->p[i]))
+			return isl_bool_true;
+	}
+
+	return isl_bool_false;
+}
+
 /* Check if map1 \ map2 is empty by checking if the set difference is empty
- * for each of the basic maps in map1.
+ * for each of the basic maps in map1, first trying cheaper tests
+ * before falling back on basic_map_diff_is_empty.
+ * "map1" and "map2" are assumed to live in the same space.
+ *
+ * A basic map in map1 that is obviously a subset of map2
+ * does not contribute anything to the difference.
+ * If bounds on the individual variables show that a basic map in map1
+ * is disjoint from map2, then it is contained in map2 if and only if
+ * it is empty.
+ *
+ * The bounds of the basic maps in map2 are only computed
+ * when they are first needed and are then reused for all
+ * remaining basic maps in map1.
+ *
+ * "decision" is set to the most expensive test that was needed
+ * to reach the result.
  */
 static isl_bool map_diff_is_empty(__isl_keep isl_map *map1,
-	__isl_keep isl_map *map2)
+	__isl_keep isl_map *map2, enum isl_subset_decision *decision)
 {
 	int i;
 	isl_bool is_empty = isl_bool_true;
+	struct isl_map_box *boxes = NULL;
 
-	if (!map1 || !map2)
-		return isl_bool_error;
-	
-	for (i = 0; i < map1->n; ++i) {
-		is_empty = basic_map_diff_is_empty(map1->p[i], map2);
-		if (is_empty < 0 || !is_empty)
-			 break;
+	*decision = isl_subset_plain;
+	for (i = 0; is_empty == isl_bool_true && i < map1->n; ++i) {
+		isl_bool covered, disjoint;
+
+		covered = basic_map_plain_is_covered(map1->p[i], map2);
+		if (covered < 0) {
+			is_empty = isl_bool_error;
+			break;
+		}
+		if (covered)
+			continue;
+
+		if (!boxes && map2->n) {
+			boxes = isl_map_boxes(map2);
+			if (!boxes) {
+				is_empty = isl_bool_error;
+				break;
+			}
+		}
+		disjoint = isl_basic_map_plain_is_box_disjoint(map1->p[i],
+							map2, boxes);
+		if (disjoint < 0) {
+			is_empty = isl_bool_error;
+		} else if (disjoint) {
+			if (*decision < isl_subset_bounds)
+				*decision = isl_subset_bounds;
+			is_empty = isl_basic_map_is_empty(map1->p[i]);
+		} else {
+			*decision = isl_subset_exact;
+			is_empty = basic_map_diff_is_empty(map1->p[i], map2);
+		}
 	}
 
+	isl_map_boxes_free(boxes, map2->n);
 	return is_empty;
 }
 
+/* Determine for each basic map in "map" whether its intersection
+ * with "bmap" is empty, storing the result in the corresponding
+ * element of "type", which is assumed to have room for map->n elements.
+ * On input, each element of "type" is either isl_intersect_empty,
+ * if the caller already knows that the corresponding basic map
+ * does not intersect "bmap", or isl_intersect_unknown.
+ * Only the latter are checked.
+ *
+ * Rather than constructing and checking each intersection separately,
+ * a single tableau is constructed for "bmap" and each basic map
+ * in "map" is temporarily added to this tableau.
+ * Basic maps with unknown divs cannot be added to the tableau and
+ * the same holds if "bmap" and "map" do not live in the same space.
+ * The result is then set to isl_intersect_unknown, as it is for
+ * intersections that are rationally, but perhaps not integrally,
+ * non-empty.  The caller needs to perform an exact check in these cases.
+ */
+isl_stat isl_basic_map_check_intersections(__isl_keep isl_basic_map *bmap,
+	__isl_keep isl_map *map, enum isl_intersect_type *type)
+{
+	int i;
+	isl_bool equal;
+	struct isl_tab *tab;
+
+	if (!bmap || !map)
+		return isl_stat_error;
+
+	equal = isl_space_is_equal(bmap->dim, map->dim);
+	if (equal < 0)
+		return isl_stat_error;
+	if (!equal || map->n == 0)
+		return isl_stat_ok;
+
+	tab = isl_tab_from_basic_map(bmap, 1);
+	if (!tab)
+		return isl_stat_error;
+
+	for (i = 0; i < map->n; ++i) {
+		isl_bool known;
+
+		if (type[i] == isl_intersect_empty)
+			continue;
+		if (tab->empty) {
+			type[i] = isl_intersect_empty;
+			continue;
+		}
+		known = isl_basic_map_divs_known(map->p[i]);
+		if (known < 0)
+			goto error;
+		if (!known)
+			continue;
+		if (tab_check_intersection(tab, map->p[i], &type[i]) < 0)
+			goto error;
+	}
+
+	isl_tab_free(tab);
+	return isl_stat_ok;
+error:
+	isl_tab_free(tab);
+	return isl_stat_error;
+}
+
 /* Return 1 if "bmap" contains a single element.
  */
 int isl_basic_map_plain_is_singleton(__isl_keep isl_basic_map *bmap)
@@ -821,6 +1146,7 @@ static isl_bool map_is_subset(__isl_keep isl_map *map1,
 	isl_bool is_subset = isl_bool_false;
 	isl_bool empty;
 	int rat1, rat2;
+	enum isl_subset_decision decision;
 
 	if (!map1 || !map2)
 		return isl_bool_error;
@@ -847,17 +1173,23 @@ static isl_bool map_is_subset(__isl_keep isl_map *map1,
 	if (rat1 && !rat2)
 		return isl_bool_false;
 
-	if (isl_map_plain_is_universe(map2))
+	if (isl_map_plain_is_universe(map2)) {
+		isl_ctx_count_subset(map1->ctx, isl_subset_universe);
 		return isl_bool_true;
+	}
 
 	map2 = isl_map_compute_divs(isl_map_copy(map2));
+	if (!map2)
+		return isl_bool_error;
 	if (isl_map_plain_is_singleton(map1)) {
+		decision = isl_subset_exact;
 		is_subset = map_is_singleton_subset(map1, map2);
-		isl_map_free(map2);
-		return is_subset;
+	} else {
+		is_subset = map_diff_is_empty(map1, map2, &decision);
 	}
-	is_subset = map_diff_is_empty(map1, map2);
 	isl_map_free(map2);
+	if (is_subset >= 0)
+		isl_ctx_count_subset(map1->ctx, decision);
 
 	return is_subset;
 }
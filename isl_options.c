@@ -42,6 +42,13 @@ static struct isl_arg_choice bound[] = {
 	{0}
 };
 
+static struct isl_arg_choice pivot_rule[] = {
+	{"bland",		ISL_PIVOT_BLAND},
+	{"steepest-edge",	ISL_PIVOT_STEEPEST_EDGE},
+	{"devex",		ISL_PIVOT_DEVEX},
+	{0}
+};
+
 static struct isl_arg_choice on_error[] = {
 	{"warn",	ISL_ON_ERROR_WARN},
 	{"continue",	ISL_ON_ERROR_CONTINUE},
@@ -119,6 +126,15 @@ ISL_ARG_CHOICE(struct isl_options, closure, 0, "closure", \
 	"closure operation to use")
 ISL_ARG_BOOL(struct isl_options, gbr_only_first, 0, "gbr-only-first", 0,
 	"only perform basis reduction in first direction")
+ISL_ARG_CHOICE(struct isl_options, pivot_rule, 0, "pivot-rule", pivot_rule,
+	ISL_PIVOT_BLAND, "rule for selecting the entering column "
+	"in primal simplex pivots")
+ISL_ARG_BOOL(struct isl_options, lp_double_start, 0, "lp-double-start", 0,
+	"start the exact computation of a rational optimum from a basis "
+	"computed in double precision")
+ISL_ARG_BOOL(struct isl_options, lp_presolve, 0, "lp-presolve", 0,
+	"remove duplicate constraints and constraints on free variables "
+	"before computing a rational optimum")
 ISL_ARG_CHOICE(struct isl_options, bound, 0, "bound", bound,
 	ISL_BOUND_BERNSTEIN, "algorithm to use for computing bounds")
 ISL_ARG_CHOICE(struct isl_options, on_error, 0, "on-error", on_error,
@@ -130,10 +146,20 @@ ISL_ARG_BOOL(struct isl_options, bernstein_triangulate, 0,
 	"triangulate domains during Bernstein expansion")
 ISL_ARG_BOOL(struct isl_options, pip_symmetry, 0, "pip-symmetry", 1,
 	"detect simple symmetries in PIP input")
+ISL_ARG_INT(struct isl_options, pip_parallel_depth, 0,
+	"pip-parallel-depth", "depth", 0, "In thread-safe mode, solve "
+	"the parts of context splits up to nesting depth <depth> "
+	"in separate threads")
 ISL_ARG_CHOICE(struct isl_options, convex, 0, "convex-hull", \
 	convex,	ISL_CONVEX_HULL_WRAP, "convex hull algorithm to use")
 ISL_ARG_BOOL(struct isl_options, coalesce_bounded_wrapping, 0,
 	"coalesce-bounded-wrapping", 1, "bound wrapping during coalescing")
+ISL_ARG_INT(struct isl_options, coalesce_cache_size, 0,
+	"coalesce-cache-size", "size", 0, "Remember the results of the last "
+	"<size> calls to isl_map_coalesce. A value of 0 disables the cache.")
+ISL_ARG_BOOL(struct isl_options, subtract_coalesce, 0,
+	"subtract-coalesce", 0, "coalesce the difference of each basic map "
+	"in isl_map_subtract as soon as it has been computed")
 ISL_ARG_INT(struct isl_options, schedule_max_coefficient, 0,
 	"schedule-max-coefficient", "limit", -1, "Only consider schedules "
 	"where the coefficients of the variable and parameter dimensions "
@@ -234,16 +260,46 @@ ISL_CTX_SET_BOOL_DEF(isl_options, struct isl_options, isl_options_args,
 ISL_CTX_GET_BOOL_DEF(isl_options, struct isl_options, isl_options_args,
 	pip_symmetry)
 
+ISL_CTX_SET_INT_DEF(isl_options, struct isl_options, isl_options_args,
+	pip_parallel_depth)
+ISL_CTX_GET_INT_DEF(isl_options, struct isl_options, isl_options_args,
+	pip_parallel_depth)
+
 ISL_CTX_SET_BOOL_DEF(isl_options, struct isl_options, isl_options_args,
 	coalesce_bounded_wrapping)
 ISL_CTX_GET_BOOL_DEF(isl_options, struct isl_options, isl_options_args,
 	coalesce_bounded_wrapping)
 
+ISL_CTX_SET_INT_DEF(isl_options, struct isl_options, isl_options_args,
+	coalesce_cache_size)
+ISL_CTX_GET_INT_DEF(isl_options, struct isl_options, isl_options_args,
+	coalesce_cache_size)
+
+ISL_CTX_SET_BOOL_DEF(isl_options, struct isl_options, isl_options_args,
+	subtract_coalesce)
+ISL_CTX_GET_BOOL_DEF(isl_options, struct isl_options, isl_options_args,
+	subtract_coalesce)
+
 ISL_CTX_SET_BOOL_DEF(isl_options, struct isl_options, isl_options_args,
 	gbr_only_first)
 ISL_CTX_GET_BOOL_DEF(isl_options, struct isl_options, isl_options_args,
 	gbr_only_first)
 
+ISL_CTX_SET_CHOICE_DEF(isl_options, struct isl_options, isl_options_args,
+	pivot_rule)
+ISL_CTX_GET_CHOICE_DEF(isl_options, struct isl_options, isl_options_args,
+	pivot_rule)
+
+ISL_CTX_SET_BOOL_DEF(isl_options, struct isl_options, isl_options_args,
+	lp_double_start)
+ISL_CTX_GET_BOOL_DEF(isl_options, struct isl_options, isl_options_args,
+	lp_double_start)
+
+ISL_CTX_SET_BOOL_DEF(isl_options, struct isl_options, isl_options_args,
+	lp_presolve)
+ISL_CTX_GET_BOOL_DEF(isl_options, struct isl_options, isl_options_args,
+	lp_presolve)
+
 ISL_CTX_SET_INT_DEF(isl_options, struct isl_options, isl_options_args,
 	schedule_max_coefficient)
 ISL_CTX_GET_INT_DEF(isl_options, struct isl_options, isl_options_args,
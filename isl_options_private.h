@@ -14,6 +14,10 @@ struct isl_options {
 	unsigned		gbr;
 	unsigned		gbr_only_first;
 
+	unsigned		pivot_rule;
+	unsigned		lp_double_start;
+	unsigned		lp_presolve;
+
 	#define			ISL_CLOSURE_ISL		0
 	#define			ISL_CLOSURE_BOX		1
 	unsigned		closure;
@@ -28,12 +32,15 @@ struct isl_options {
 	int			bernstein_triangulate;
 
 	int			pip_symmetry;
+	int			pip_parallel_depth;
 
 	#define			ISL_CONVEX_HULL_WRAP	0
 	#define			ISL_CONVEX_HULL_FM	1
 	int			convex;
 
 	int			coalesce_bounded_wrapping;
+	int			coalesce_cache_size;
+	int			subtract_coalesce;
 
 	int			schedule_max_coefficient;
 	int			schedule_max_constant_term;
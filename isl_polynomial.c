@@ -2168,21 +2168,22 @@ __isl_give struct isl_upoly *isl_upoly_from_affine(isl_ctx *ctx, isl_int *f,
  */
 static void normalize_div(__isl_keep isl_qpolynomial *qp, int div)
 {
-	isl_ctx *ctx = qp->div->ctx;
 	unsigned total = qp->div->n_col - 2;
+	isl_int local, *gcd;
+	isl_ctx *ctx = qp->div->ctx;
 
-	isl_seq_gcd(qp->div->row[div] + 2, total, &ctx->normalize_gcd);
-	isl_int_gcd(ctx->normalize_gcd,
-		    ctx->normalize_gcd, qp->div->row[div][0]);
-	if (isl_int_is_one(ctx->normalize_gcd))
-		return;
-
-	isl_seq_scale_down(qp->div->row[div] + 2, qp->div->row[div] + 2,
-			    ctx->normalize_gcd, total);
-	isl_int_divexact(qp->div->row[div][0], qp->div->row[div][0],
-			    ctx->normalize_gcd);
-	isl_int_fdiv_q(qp->div->row[div][1], qp->div->row[div][1],
-			    ctx->normalize_gcd);
+	gcd = isl_ctx_get_normalize_gcd(ctx, &local);
+	isl_seq_gcd(qp->div->row[div] + 2, total, gcd);
+	isl_int_gcd(*gcd, *gcd, qp->div->row[div][0]);
+	if (!isl_int_is_one(*gcd)) {
+		isl_seq_scale_down(qp->div->row[div] + 2,
+				qp->div->row[div] + 2, *gcd, total);
+		isl_int_divexact(qp->div->row[div][0],
+				qp->div->row[div][0], *gcd);
+		isl_int_fdiv_q(qp->div->row[div][1],
+				qp->div->row[div][1], *gcd);
+	}
+	isl_ctx_release_normalize_gcd(ctx, gcd);
 }
 
 /* Replace the integer division identified by "div" by the polynomial "s".
@@ -369,6 +369,8 @@ static int greedy_search(isl_ctx *ctx, struct isl_tab *tab,
  * When ctx->opt->gbr is set to ISL_GBR_ALWAYS, then we allow the basis
  * reduction computation to return early.  That is, as soon as it
  * finds a reasonable first direction.
+ * The options themselves are not modified since the isl_ctx
+ * may be used by other threads at the same time.
  */ 
 struct isl_vec *isl_tab_sample(struct isl_tab *tab)
 {
@@ -456,17 +458,13 @@ struct isl_vec *isl_tab_sample(struct isl_tab *tab)
 				if (g)
 					break;
 			}
-			if (!reduced && choice &&
-			    ctx->opt->gbr != ISL_GBR_NEVER) {
-				unsigned gbr_only_first;
-				if (ctx->opt->gbr == ISL_GBR_ONCE)
-					ctx->opt->gbr = ISL_GBR_NEVER;
+			if (!reduced && choice && gbr != ISL_GBR_NEVER) {
+				int only_first = gbr == ISL_GBR_ALWAYS;
+				if (gbr == ISL_GBR_ONCE)
+					gbr = ISL_GBR_NEVER;
 				tab->n_zero = level;
-				gbr_only_first = ctx->opt->gbr_only_first;
-				ctx->opt->gbr_only_first =
-					ctx->opt->gbr == ISL_GBR_ALWAYS;
-				tab = isl_tab_compute_reduced_basis(tab);
-				ctx->opt->gbr_only_first = gbr_only_first;
+				tab = isl_tab_compute_reduced_basis_only_first(
+							tab, only_first);
 				if (!tab || !tab->basis)
 					goto error;
 				reduced = 1;
@@ -511,13 +509,11 @@ struct isl_vec *isl_tab_sample(struct isl_tab *tab)
 	} else
 		sample = isl_vec_alloc(ctx, 0);
 
-	ctx->opt->gbr = gbr;
 	isl_vec_free(min);
 	isl_vec_free(max);
 	free(snap);
 	return sample;
 error:
-	ctx->opt->gbr = gbr;
 	isl_vec_free(min);
 	isl_vec_free(max);
 	free(snap);
@@ -10,6 +10,150 @@
 #include <isl_ctx_private.h>
 #include <isl_seq.h>
 
+#ifdef USE_SMALL_INT_OPT
+
+/* Are all "len" elements of "p" stored in small representation?
+ * The discriminator bits are combined without any branching
+ * such that the compiler can vectorize the loop.
+ */
+static int seq_is_small(isl_int *p, unsigned len)
+{
+	int i;
+	isl_sioimath small = 1;
+
+	for (i = 0; i < len; ++i)
+		small &= p[i][0];
+	return isl_sioimath_is_small(small);
+}
+
+/* Set dst to f * src + sgn * dst, with sgn either 1 or -1, directly
+ * on the native integers if "f" and all elements of "dst" and "src"
+ * are stored in small representation.
+ * Each product is smaller than 2^62 in absolute value so that
+ * the result always fits in an int64_t.
+ *
+ * Return 1 if the operation was performed and 0 otherwise.
+ */
+static int addmul_small(isl_int *dst, int sgn, isl_int f, isl_int *src,
+	unsigned len)
+{
+	int i;
+	int32_t small_f;
+
+	if (!isl_sioimath_decode_small(*f, &small_f))
+		return 0;
+	if (!seq_is_small(dst, len) || !seq_is_small(src, len))
+		return 0;
+	for (i = 0; i < len; ++i) {
+		int64_t d = isl_sioimath_get_small(dst[i][0]);
+		int64_t s = isl_sioimath_get_small(src[i][0]);
+		isl_sioimath_set_int64(dst[i], d + sgn * small_f * s);
+	}
+	return 1;
+}
+
+/* Set dst to m1 * src1 + m2 * src2 directly on the native integers
+ * if "m1", "m2" and all elements of "src1" and "src2"
+ * are stored in small representation.
+ * "dst" may be equal to "src1" or "src2".
+ *
+ * Return 1 if the operation was performed and 0 otherwise.
+ */
+static int combine_small(isl_int *dst, isl_int m1, isl_int *src1,
+	isl_int m2, isl_int *src2, unsigned len)
+{
+	int i;
+	int32_t small_m1, small_m2;
+
+	if (!isl_sioimath_decode_small(*m1, &small_m1) ||
+	    !isl_sioimath_decode_small(*m2, &small_m2))
+		return 0;
+	if (!seq_is_small(src1, len) || !seq_is_small(src2, len))
+		return 0;
+	for (i = 0; i < len; ++i) {
+		int64_t s1 = isl_sioimath_get_small(src1[i][0]);
+		int64_t s2 = isl_sioimath_get_small(src2[i][0]);
+		isl_sioimath_set_int64(dst[i], small_m1 * s1 + small_m2 * s2);
+	}
+	return 1;
+}
+
+/* Set dst to src / f if "f" and all elements of "src" are stored
+ * in small representation.  The division is assumed to be exact.
+ * Since INT32_MIN is excluded from the small representation,
+ * the result is always small as well.
+ *
+ * Return 1 if the operation was performed and 0 otherwise.
+ */
+static int scale_down_small(isl_int *dst, isl_int *src, isl_int f,
+	unsigned len)
+{
+	int i;
+	int32_t small_f;
+
+	if (!isl_sioimath_decode_small(*f, &small_f))
+		return 0;
+	if (!seq_is_small(src, len))
+		return 0;
+	for (i = 0; i < len; ++i)
+		isl_sioimath_set_small(dst[i],
+			isl_sioimath_get_small(src[i][0]) / small_f);
+	return 1;
+}
+
+/* Compute the gcd of the elements of "p" using native integers
+ * if they are all stored in small representation.
+ *
+ * Return 1 if the gcd was computed and 0 otherwise.
+ */
+static int gcd_small(isl_int *p, unsigned len, isl_int *gcd)
+{
+	int i;
+	uint32_t g = 0;
+
+	if (!seq_is_small(p, len))
+		return 0;
+	for (i = 0; g != 1 && i < len; ++i) {
+		int32_t v = isl_sioimath_get_small(p[i][0]);
+		uint32_t a = v < 0 ? -v : v;
+
+		while (a) {
+			uint32_t t = g % a;
+			g = a;
+			a = t;
+		}
+	}
+	isl_int_set_ui(*gcd, g);
+	return 1;
+}
+
+#else
+
+static int addmul_small(isl_int *dst, int sgn, isl_int f, isl_int *src,
+	unsigned len)
+{
+	return 0;
+}
+
+static int combine_small(isl_int *dst, isl_int m1, isl_int *src1,
+	isl_int m2, isl_int *src2, unsigned len)
+{
+	return 0;
+}
+
+static int scale_down_small(isl_int *dst, isl_int *src, isl_int f,
+	unsigned len)
+{
+	return 0;
+}
+
+static int gcd_small(isl_int *p, unsigned len, isl_int *gcd)
+{
+	return 0;
+}
+
+#endif
+
 void isl_seq_clr(isl_int *p, unsigned len)
 {
 	int i;
@@ -48,6 +192,9 @@ void isl_seq_cpy(isl_int *dst, isl_int *src, unsigned len)
 void isl_seq_submul(isl_int *dst, isl_int f, isl_int *src, unsigned len)
 {
 	int i;
+
+	if (addmul_small(dst, -1, f, src, len))
+		return;
 	for (i = 0; i < len; ++i)
 		isl_int_submul(dst[i], f, src[i]);
 }
@@ -55,6 +202,9 @@ void isl_seq_submul(isl_int *dst, isl_int f, isl_int *src, unsigned len)
 void isl_seq_addmul(isl_int *dst, isl_int f, isl_int *src, unsigned len)
 {
 	int i;
+
+	if (addmul_small(dst, 1, f, src, len))
+		return;
 	for (i = 0; i < len; ++i)
 		isl_int_addmul(dst[i], f, src[i]);
 }
@@ -76,6 +226,9 @@ void isl_seq_scale(isl_int *dst, isl_int *src, isl_int m, unsigned len)
 void isl_seq_scale_down(isl_int *dst, isl_int *src, isl_int m, unsigned len)
 {
 	int i;
+
+	if (scale_down_small(dst, src, m, len))
+		return;
 	for (i = 0; i < len; ++i)
 		isl_int_divexact(dst[i], src[i], m);
 }
@@ -110,11 +263,13 @@ void isl_seq_combine(isl_int *dst, isl_int m1, isl_int *src1,
 	if (dst == src1 && isl_int_is_one(m1)) {
 		if (isl_int_is_zero(m2))
 			return;
-		for (i = 0; i < len; ++i)
-			isl_int_addmul(src1[i], m2, src2[i]);
+		isl_seq_addmul(src1, m2, src2, len);
 		return;
 	}
 
+	if (combine_small(dst, m1, src1, m2, src2, len))
+		return;
+
 	isl_int_init(tmp);
 	for (i = 0; i < len; ++i) {
 		isl_int_mul(tmp, m1, src1[i]);
@@ -155,12 +310,26 @@ void isl_seq_elim(isl_int *dst, isl_int *src, unsigned pos, unsigned len,
 	isl_int_clear(b);
 }
 
+/* Check whether "p1" and "p2" are equal.
+ * If small integers are stored in the isl_int itself, then
+ * identical representations imply equal values and two different
+ * small representations imply different values.
+ * Only pairs that involve a big representation need to be compared
+ * using isl_int_ne.
+ */
 int isl_seq_eq(isl_int *p1, isl_int *p2, unsigned len)
 {
 	int i;
-	for (i = 0; i < len; ++i)
+	for (i = 0; i < len; ++i) {
+#ifdef USE_SMALL_INT_OPT
+		if (p1[i][0] == p2[i][0])
+			continue;
+		if (isl_sioimath_is_small(p1[i][0] & p2[i][0]))
+			return 0;
+#endif
 		if (isl_int_ne(p1[i], p2[i]))
 			return 0;
+	}
 	return 1;
 }
 
@@ -236,8 +405,12 @@ int isl_seq_abs_min_non_zero(isl_int *p, unsigned len)
 
 void isl_seq_gcd(isl_int *p, unsigned len, isl_int *gcd)
 {
-	int i, min = isl_seq_abs_min_non_zero(p, len);
+	int i, min;
 
+	if (gcd_small(p, len, gcd))
+		return;
+
+	min = isl_seq_abs_min_non_zero(p, len);
 	if (min < 0) {
 		isl_int_set_si(*gcd, 0);
 		return;
@@ -254,12 +427,15 @@ void isl_seq_gcd(isl_int *p, unsigned len, isl_int *gcd)
 
 void isl_seq_normalize(struct isl_ctx *ctx, isl_int *p, unsigned len)
 {
+	isl_int local, *gcd;
+
 	if (len == 0)
 		return;
-	isl_seq_gcd(p, len, &ctx->normalize_gcd);
-	if (!isl_int_is_zero(ctx->normalize_gcd) &&
-	    !isl_int_is_one(ctx->normalize_gcd))
-		isl_seq_scale_down(p, p, ctx->normalize_gcd, len);
+	gcd = isl_ctx_get_normalize_gcd(ctx, &local);
+	isl_seq_gcd(p, len, gcd);
+	if (!isl_int_is_zero(*gcd) && !isl_int_is_one(*gcd))
+		isl_seq_scale_down(p, p, *gcd, len);
+	isl_ctx_release_normalize_gcd(ctx, gcd);
 }
 
 void isl_seq_lcm(isl_int *p, unsigned len, isl_int *lcm)
@@ -0,0 +1,385 @@
+/*
+ * Copyright 2017      Sven Verdoolaege
+ *
+ * Use of this software is governed by the MIT license
+ */
+
+#include <isl_ctx_private.h>
+#include <isl_map_private.h>
+#include <isl/solver.h>
+#include <isl_seq.h>
+#include <isl_tab.h>
+#include <isl_aff_private.h>
+#include <isl_constraint_private.h>
+#include <isl_local_space_private.h>
+#include <isl_ilp_private.h>
+#include <isl_val_private.h>
+#include <isl_vec_private.h>
+
+/* An incremental solver for a basic set.
+ *
+ * "tab" is a tableau representing the basic set, with the constraints
+ * that were added to the solver included.  It keeps track of
+ * the corresponding basic set.
+ * "snap" contains "n" snapshots of "tab", one for each constraint scope
+ * that is currently open, in the order in which they were opened.
+ * "size" is the number of allocated elements in "snap".
+ */
+struct isl_solver {
+	isl_ctx *ctx;
+	struct isl_tab *tab;
+
+	int n;
+	int size;
+	struct isl_tab_undo **snap;
+};
+
+/* Construct an incremental solver for "bset".
+ */
+__isl_give isl_solver *isl_solver_from_basic_set(
+	__isl_take isl_basic_set *bset)
+{
+	isl_ctx *ctx;
+	isl_solver *solver;
+
+	bset = isl_basic_set_gauss(bset, NULL);
+	if (!bset)
+		return NULL;
+
+	ctx = isl_basic_set_get_ctx(bset);
+	solver = isl_calloc_type(ctx, struct isl_solver);
+	if (!solver)
+		goto error;
+
+	solver->ctx = ctx;
+	isl_ctx_ref(ctx);
+	solver->tab = isl_tab_from_basic_set(bset, 1);
+	isl_basic_set_free(bset);
+	if (!solver->tab)
+		return isl_solver_free(solver);
+
+	return solver;
+error:
+	isl_basic_set_free(bset);
+	return NULL;
+}
+
+isl_ctx *isl_solver_get_ctx(__isl_keep isl_solver *solver)
+{
+	return solver ? solver->ctx : NULL;
+}
+
+__isl_null isl_solver *isl_solver_free(__isl_take isl_solver *solver)
+{
+	if (!solver)
+		return NULL;
+
+	isl_tab_free(solver->tab);
+	free(solver->snap);
+	isl_ctx_deref(solver->ctx);
+	free(solver);
+
+	return NULL;
+}
+
+/* Stop keeping track of undo information in the tableau of "solver"
+ * if there are no open constraint scopes.
+ * Otherwise, the undo records would accumulate with every constraint
+ * that is added outside of any scope.
+ */
+static void solver_drop_undo(__isl_keep isl_solver *solver)
+{
+	if (solver->n == 0)
+		isl_tab_clear_undo(solver->tab);
+}
+
+/* Open a new constraint scope in "solver".
+ * The constraints that are added to "solver" afterwards
+ * are removed again by the matching call to isl_solver_pop.
+ */
+__isl_give isl_solver *isl_solver_push(__isl_take isl_solver *solver)
+{
+	if (!solver)
+		return NULL;
+
+	if (solver->n >= solver->size) {
+		struct isl_tab_undo **snap;
+		int size = 3 * solver->size / 2 + 4;
+
+		snap = isl_realloc_array(solver->ctx, solver->snap,
+					struct isl_tab_undo *, size);
+		if (!snap)
+			return isl_solver_free(solver);
+		solver->snap = snap;
+		solver->size = size;
+	}
+
+	solver->snap[solver->n++] = isl_tab_snap(solver->tab);
+
+	return solver;
+}
+
+/* Close the most recently opened constraint scope in "solver",
+ * removing all constraints that were added since it was opened.
+ */
+__isl_give isl_solver *isl_solver_pop(__isl_take isl_solver *solver)
+{
+	if (!solver)
+		return NULL;
+
+	if (solver->n == 0)
+		isl_die(solver->ctx, isl_error_invalid,
+			"no open constraint scope",
+			return isl_solver_free(solver));
+
+	solver->n--;
+	if (isl_tab_rollback(solver->tab, solver->snap[solver->n]) < 0)
+		return isl_solver_free(solver);
+	solver_drop_undo(solver);
+
+	return solver;
+}
+
+/* Return a copy of the "n" coefficients in "c", which live in the space
+ * of the basic set of "solver", extended with zero coefficients
+ * for the local variables of this basic set.
+ */
+static __isl_give isl_vec *extend_coefficients(__isl_keep isl_solver *solver,
+	isl_int *c, unsigned n)
+{
+	unsigned total;
+	isl_vec *ext;
+
+	total = isl_basic_set_total_dim(isl_tab_peek_bset(solver->tab));
+	ext = isl_vec_alloc(solver->ctx, 1 + total);
+	if (!ext)
+		return NULL;
+	isl_seq_cpy(ext->el, c, n);
+	isl_seq_clr(ext->el + n, 1 + total - n);
+
+	return ext;
+}
+
+/* Add "constraint" to "solver", within the most recently opened
+ * constraint scope, if any.
+ *
+ * The constraint is required to live in the space of the basic set
+ * of "solver" and is not allowed to involve any local variables.
+ * If the solver is already known to be empty, then there is no need
+ * to add the constraint.
+ */
+__isl_give isl_solver *isl_solver_add_constraint(
+	__isl_take isl_solver *solver, __isl_take isl_constraint *constraint)
+{
+	isl_basic_set *bset;
+	isl_bool equal;
+	isl_vec *v;
+	int r;
+
+	if (!solver || !constraint)
+		goto error;
+
+	bset = isl_tab_peek_bset(solver->tab);
+	equal = isl_space_is_equal(bset->dim, constraint->ls->dim);
+	if (equal < 0)
+		goto error;
+	if (!equal)
+		isl_die(solver->ctx, isl_error_invalid,
+			"spaces don't match", goto error);
+	if (isl_local_space_dim(constraint->ls, isl_dim_div) != 0)
+		isl_die(solver->ctx, isl_error_unsupported,
+			"constraint involves local variables", goto error);
+
+	if (solver->tab->empty) {
+		isl_constraint_free(constraint);
+		return solver;
+	}
+
+	v = extend_coefficients(solver, constraint->v->el, constraint->v->size);
+	if (!v || isl_tab_extend_cons(solver->tab, 2) < 0)
+		r = -1;
+	else if (constraint->eq)
+		r = isl_tab_add_eq(solver->tab, v->el);
+	else
+		r = isl_tab_add_ineq(solver->tab, v->el);
+	isl_vec_free(v);
+	isl_constraint_free(constraint);
+	if (r < 0)
+		return isl_solver_free(solver);
+
+	return solver;
+error:
+	isl_constraint_free(constraint);
+	isl_solver_free(solver);
+	return NULL;
+}
+
+/* Is the rational relaxation of the basic set of "solver" empty?
+ * The tableau is kept in a feasible state, so this information
+ * is readily available.
+ */
+isl_bool isl_solver_is_rational_empty(__isl_keep isl_solver *solver)
+{
+	if (!solver)
+		return isl_bool_error;
+
+	return solver->tab->empty;
+}
+
+/* Is the basic set of "solver" empty?
+ *
+ * If the rational relaxation is empty or if the current sample value
+ * of the tableau is integral, then we can answer the question
+ * without any further computation.
+ * Otherwise, fall back on isl_basic_set_is_empty.
+ * This function is applied to a duplicate of the basic set
+ * tracked by the tableau because it may mark its argument as empty,
+ * while the constraints that cause the emptiness may get removed
+ * by a subsequent call to isl_solver_pop.
+ */
+isl_bool isl_solver_is_empty(__isl_keep isl_solver *solver)
+{
+	int integer;
+	isl_basic_set *bset;
+	isl_bool empty;
+
+	if (!solver)
+		return isl_bool_error;
+
+	if (solver->tab->empty)
+		return isl_bool_true;
+	if (solver->tab->rational)
+		return isl_bool_false;
+	integer = isl_tab_sample_is_integer(solver->tab);
+	if (integer < 0)
+		return isl_bool_error;
+	if (integer)
+		return isl_bool_false;
+
+	bset = isl_basic_set_dup(isl_tab_peek_bset(solver->tab));
+	empty = isl_basic_set_is_empty(bset);
+	isl_basic_set_free(bset);
+
+	return empty;
+}
+
+/* Return the minimum (maximum if "max" is set) of the integer affine
+ * expression "obj" over the points in the basic set of "solver"
+ * using isl_basic_set_opt_val.
+ * As in isl_solver_is_empty, this function is applied to a duplicate
+ * of the basic set tracked by the tableau.
+ */
+static __isl_give isl_val *basic_set_opt_val(__isl_keep isl_solver *solver,
+	int max, __isl_keep isl_aff *obj)
+{
+	isl_basic_set *bset;
+	isl_val *res;
+
+	bset = isl_basic_set_dup(isl_tab_peek_bset(solver->tab));
+	res = isl_basic_set_opt_val(bset, max, obj);
+	isl_basic_set_free(bset);
+
+	return res;
+}
+
+/* Return the minimum (maximum if "max" is set) of the integer affine
+ * expression "obj" over the points in the basic set of "solver".
+ *
+ * Return infinity or negative infinity if the optimal value is unbounded and
+ * NaN if the basic set is empty.
+ *
+ * We first compute the rational optimum using the tableau.
+ * If this optimum is attained in an integer point, then it is
+ * also the integer optimum.  If the rational problem is unbounded,
+ * then so is the integer problem, unless it does not have any
+ * integer points.
+ * In all other cases, as well as when "obj" involves local variables
+ * or when the basic set is rational, we fall back
+ * on isl_basic_set_opt_val through basic_set_opt_val.
+ */
+static __isl_give isl_val *solver_opt_val(__isl_keep isl_solver *solver,
+	int max, __isl_keep isl_aff *obj)
+{
+	isl_basic_set *bset;
+	isl_bool equal;
+	isl_vec *f;
+	isl_val *res = NULL;
+	enum isl_lp_result lp_res;
+	isl_int opt, opt_denom;
+	int integer;
+
+	if (!solver || !obj)
+		return NULL;
+
+	bset = isl_tab_peek_bset(solver->tab);
+	equal = isl_space_is_equal(bset->dim, obj->ls->dim);
+	if (equal < 0)
+		return NULL;
+	if (!equal)
+		isl_die(solver->ctx, isl_error_invalid,
+			"spaces don't match", return NULL);
+	if (solver->tab->empty)
+		return isl_val_nan(solver->ctx);
+	if (solver->tab->rational || !isl_int_is_one(obj->v->el[0]) ||
+	    isl_aff_dim(obj, isl_dim_div) != 0)
+		return basic_set_opt_val(solver, max, obj);
+
+	f = extend_coefficients(solver, obj->v->el + 1, obj->v->size - 1);
+	if (!f || isl_tab_extend_cons(solver->tab, 1) < 0) {
+		isl_vec_free(f);
+		return NULL;
+	}
+	if (max)
+		isl_seq_neg(f->el, f->el, f->size);
+
+	isl_int_init(opt);
+	isl_int_init(opt_denom);
+	lp_res = isl_tab_min(solver->tab, f->el, solver->ctx->one,
+				&opt, &opt_denom, 0);
+	solver_drop_undo(solver);
+	isl_vec_free(f);
+	integer = 0;
+	if (lp_res == isl_lp_ok)
+		integer = isl_tab_sample_is_integer(solver->tab);
+	if (lp_res == isl_lp_error || integer < 0) {
+		res = NULL;
+	} else if (lp_res == isl_lp_ok && integer) {
+		if (max)
+			isl_int_neg(opt, opt);
+		res = isl_val_rat_from_isl_int(solver->ctx, opt, opt_denom);
+	} else if (lp_res == isl_lp_unbounded) {
+		isl_bool empty = isl_solver_is_empty(solver);
+		if (empty < 0)
+			res = NULL;
+		else if (empty)
+			res = isl_val_nan(solver->ctx);
+		else if (max)
+			res = isl_val_infty(solver->ctx);
+		else
+			res = isl_val_neginfty(solver->ctx);
+	} else {
+		res = basic_set_opt_val(solver, max, obj);
+	}
+	isl_int_clear(opt_denom);
+	isl_int_clear(opt);
+
+	return res;
+}
+
+/* Return the minimum of the integer affine expression "obj"
+ * over the points in the basic set of "solver".
+ */
+__isl_give isl_val *isl_solver_min_val(__isl_keep isl_solver *solver,
+	__isl_keep isl_aff *obj)
+{
+	return solver_opt_val(solver, 0, obj);
+}
+
+/* Return the maximum of the integer affine expression "obj"
+ * over the points in the basic set of "solver".
+ */
+__isl_give isl_val *isl_solver_max_val(__isl_keep isl_solver *solver,
+	__isl_keep isl_aff *obj)
+{
+	return solver_opt_val(solver, 1, obj);
+}
@@ -14,6 +14,7 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include <isl_ctx_private.h>
 #include <isl_space_private.h>
 #include <isl_id_private.h>
 #include <isl_reordering.h>
@@ -35,6 +36,7 @@ __isl_give isl_space *isl_space_alloc(isl_ctx *ctx,
 	dim->ctx = ctx;
 	isl_ctx_ref(ctx);
 	dim->ref = 1;
+	dim->hash = 0;
 	dim->nparam = nparam;
 	dim->n_in = n_in;
 	dim->n_out = n_out;
@@ -318,15 +320,23 @@ error:
 	return NULL;
 }
 
+/* Return a copy of "dim" that may be modified by the caller.
+ * Since the caller will modify the result, drop any cached hash value.
+ */
 __isl_give isl_space *isl_space_cow(__isl_take isl_space *dim)
 {
+	isl_space *dup;
+
 	if (!dim)
 		return NULL;
 
-	if (dim->ref == 1)
+	if (isl_ctx_get_ref(dim->ctx, &dim->ref) == 1) {
+		dim->hash = 0;
 		return dim;
-	dim->ref--;
-	return isl_space_dup(dim);
+	}
+	dup = isl_space_dup(dim);
+	isl_space_free(dim);
+	return dup;
 }
 
 __isl_give isl_space *isl_space_copy(__isl_keep isl_space *dim)
@@ -334,7 +344,7 @@ __isl_give isl_space *isl_space_copy(__isl_keep isl_space *dim)
 	if (!dim)
 		return NULL;
 
-	dim->ref++;
+	isl_ctx_inc_ref(dim->ctx, &dim->ref);
 	return dim;
 }
 
@@ -345,7 +355,7 @@ __isl_null isl_space *isl_space_free(__isl_take isl_space *space)
 	if (!space)
 		return NULL;
 
-	if (--space->ref > 0)
+	if (isl_ctx_dec_ref(space->ctx, &space->ref) > 0)
 		return NULL;
 
 	isl_id_free(space->tuple_id[0]);
@@ -1819,15 +1829,48 @@ __isl_give isl_space *isl_space_underlying(__isl_take isl_space *dim,
 	return dim;
 }
 
+/* Return the hash value cached in "space", or zero if there is none.
+ * The value is read atomically since another thread may be
+ * storing the hash value of a shared space at the same time.
+ */
+static uint32_t get_cached_hash(__isl_keep isl_space *space)
+{
+#ifdef ISL_HAVE_ATOMIC
+	return __atomic_load_n(&space->hash, __ATOMIC_RELAXED);
+#else
+	return space->hash;
+#endif
+}
+
+/* Cache "hash" as the hash value of "space".
+ * Other threads may store the same value at the same time.
+ */
+static void set_cached_hash(__isl_keep isl_space *space, uint32_t hash)
+{
+#ifdef ISL_HAVE_ATOMIC
+	__atomic_store_n(&space->hash, hash, __ATOMIC_RELAXED);
+#else
+	space->hash = hash;
+#endif
+}
+
 /* Are the two spaces the same, including positions and names of parameters?
+ * If both spaces have a cached hash value and these values are different,
+ * then the spaces are obviously different.
  */
 isl_bool isl_space_is_equal(__isl_keep isl_space *dim1,
 	__isl_keep isl_space *dim2)
 {
+	uint32_t hash1, hash2;
+
 	if (!dim1 || !dim2)
 		return isl_bool_error;
 	if (dim1 == dim2)
 		return isl_bool_true;
+	hash1 = get_cached_hash(dim1);
+	hash2 = get_cached_hash(dim2);
+	if (hash1 && hash2 && hash1 != hash2)
+		return isl_bool_false;
 	return match(dim1, isl_dim_param, dim2, isl_dim_param) &&
 	       isl_space_tuple_is_equal(dim1, isl_dim_in, dim2, isl_dim_in) &&
 	       isl_space_tuple_is_equal(dim1, isl_dim_out, dim2, isl_dim_out);
@@ -1905,7 +1948,8 @@ int isl_space_compatible(__isl_keep isl_space *space1,
 }
 
 /* Update "hash" by hashing in "space".
- * Changes in this function should be reflected in isl_hash_space_domain.
+ * Changes in this function should be reflected in isl_hash_space_domain
+ * and isl_hash_space_range.
  */
 static uint32_t isl_hash_space(uint32_t hash, __isl_keep isl_space *space)
 {
@@ -1966,15 +2010,54 @@ static uint32_t isl_hash_space_domain(uint32_t hash,
 	return hash;
 }
 
+/* Update "hash" by hashing in the range of "space".
+ * The result of this function is equal to the result of applying
+ * isl_hash_space to the range of "space".
+ */
+static uint32_t isl_hash_space_range(uint32_t hash,
+	__isl_keep isl_space *space)
+{
+	int i;
+	isl_id *id;
+
+	if (!space)
+		return hash;
+
+	isl_hash_byte(hash, space->nparam % 256);
+	isl_hash_byte(hash, 0);
+	isl_hash_byte(hash, space->n_out % 256);
+
+	for (i = 0; i < space->nparam; ++i) {
+		id = get_id(space, isl_dim_param, i);
+		hash = isl_hash_id(hash, id);
+	}
+
+	hash = isl_hash_id(hash, &isl_id_none);
+	id = tuple_id(space, isl_dim_out);
+	hash = isl_hash_id(hash, id);
+
+	hash = isl_hash_space(hash, space->nested[1]);
+
+	return hash;
+}
+
+/* Return the hash value of "dim".
+ * The hash value is cached in "dim" since it is needed
+ * for every lookup of "dim" in a hash table.
+ */
 uint32_t isl_space_get_hash(__isl_keep isl_space *dim)
 {
 	uint32_t hash;
 
 	if (!dim)
 		return 0;
+	hash = get_cached_hash(dim);
+	if (hash)
+		return hash;
 
 	hash = isl_hash_init();
 	hash = isl_hash_space(hash, dim);
+	set_cached_hash(dim, hash);
 
 	return hash;
 }
@@ -1996,6 +2079,23 @@ uint32_t isl_space_get_domain_hash(__isl_keep isl_space *space)
 	return hash;
 }
 
+/* Return the hash value of the range of "space".
+ * That is, isl_space_get_range_hash(space) is equal to
+ * isl_space_get_hash(isl_space_range(space)).
+ */
+uint32_t isl_space_get_range_hash(__isl_keep isl_space *space)
+{
+	uint32_t hash;
+
+	if (!space)
+		return 0;
+
+	hash = isl_hash_init();
+	hash = isl_hash_space_range(hash, space);
+
+	return hash;
+}
+
 isl_bool isl_space_is_wrapping(__isl_keep isl_space *dim)
 {
 	if (!dim)
@@ -6,9 +6,19 @@
 #include <isl/id.h>
 
 struct isl_name;
+
+/* If "hash" is not zero, then it holds the cached result
+ * of isl_space_get_hash.  A hash value of zero is simply not cached.
+ * The cached value is dropped whenever the space is about
+ * to be modified (in isl_space_cow).
+ * Since a space may be shared between threads in thread-safe mode,
+ * "hash" is only accessed through get_cached_hash and set_cached_hash.
+ */
 struct isl_space {
 	int ref;
 
+	uint32_t hash;
+
 	struct isl_ctx *ctx;
 
 	unsigned nparam;
@@ -29,6 +39,7 @@ __isl_give isl_space *isl_space_underlying(__isl_take isl_space *dim,
 
 uint32_t isl_space_get_hash(__isl_keep isl_space *dim);
 uint32_t isl_space_get_domain_hash(__isl_keep isl_space *space);
+uint32_t isl_space_get_range_hash(__isl_keep isl_space *space);
 
 isl_bool isl_space_is_domain_internal(__isl_keep isl_space *space1,
 	__isl_keep isl_space *space2);
@@ -12,7 +12,9 @@
  * B.P. 105 - 78153 Le Chesnay, France
  */
 
+#include <limits.h>
 #include <isl_ctx_private.h>
+#include <isl_options_private.h>
 #include <isl_mat_private.h>
 #include <isl_vec_private.h>
 #include "isl_map_private.h"
@@ -62,6 +64,7 @@ struct isl_tab *isl_tab_alloc(struct isl_ctx *ctx,
 		tab->var[i].is_redundant = 0;
 		tab->var[i].frozen = 0;
 		tab->var[i].negated = 0;
+		tab->var[i].weight = 1;
 		tab->col_var[i] = i;
 	}
 	tab->n_row = 0;
@@ -85,6 +88,8 @@ struct isl_tab *isl_tab_alloc(struct isl_ctx *ctx,
 	tab->bottom.type = isl_tab_undo_bottom;
 	tab->bottom.next = NULL;
 	tab->top = &tab->bottom;
+	tab->unused_undo = NULL;
+	tab->undo_chunk = NULL;
 
 	tab->n_zero = 0;
 	tab->n_unbounded = 0;
@@ -178,7 +183,55 @@ int isl_tab_extend_vars(struct isl_tab *tab, unsigned n_new)
 	return 0;
 }
 
-static void free_undo_record(struct isl_tab_undo *undo)
+/* The number of undo records in a chunk allocated by alloc_undo_record.
+ */
+#define ISL_TAB_UNDO_CHUNK_SIZE	64
+
+/* A chunk of undo records owned by a tableau.
+ * "next" is the next chunk owned by the same tableau.
+ */
+struct isl_tab_undo_chunk {
+	struct isl_tab_undo_chunk *next;
+	struct isl_tab_undo undo[ISL_TAB_UNDO_CHUNK_SIZE];
+};
+
+/* Return an undo record that can be pushed onto the undo stack of "tab".
+ *
+ * The record is taken from the list of unused records, if any.
+ * Otherwise, a new chunk of records is allocated and all but
+ * the first record of this chunk are added to the list of unused records.
+ * The records are not moved or freed until the tableau is freed,
+ * so snapshots, which point to records, remain valid.
+ */
+static struct isl_tab_undo *alloc_undo_record(struct isl_tab *tab)
+{
+	int i;
+	struct isl_tab_undo *undo;
+	struct isl_tab_undo_chunk *chunk;
+
+	if (tab->unused_undo) {
+		undo = tab->unused_undo;
+		tab->unused_undo = undo->next;
+		return undo;
+	}
+
+	chunk = isl_alloc_type(tab->mat->ctx, struct isl_tab_undo_chunk);
+	if (!chunk)
+		return NULL;
+	chunk->next = tab->undo_chunk;
+	tab->undo_chunk = chunk;
+	for (i = ISL_TAB_UNDO_CHUNK_SIZE - 1; i >= 1; --i) {
+		chunk->undo[i].next = tab->unused_undo;
+		tab->unused_undo = &chunk->undo[i];
+	}
+	return &chunk->undo[0];
+}
+
+/* Release the undo record "undo", which has been popped off
+ * the undo stack of "tab", along with any memory it owns.
+ * The record itself is kept for later reuse.
+ */
+static void free_undo_record(struct isl_tab *tab, struct isl_tab_undo *undo)
 {
 	switch (undo->type) {
 	case isl_tab_undo_saved_basis:
@@ -186,7 +239,8 @@ static void free_undo_record(struct isl_tab_undo *undo)
 		break;
 	default:;
 	}
-	free(undo);
+	undo->next = tab->unused_undo;
+	tab->unused_undo = undo;
 }
 
 static void free_undo(struct isl_tab *tab)
@@ -195,16 +249,31 @@ static void free_undo(struct isl_tab *tab)
 
 	for (undo = tab->top; undo && undo != &tab->bottom; undo = next) {
 		next = undo->next;
-		free_undo_record(undo);
+		free_undo_record(tab, undo);
 	}
 	tab->top = undo;
 }
 
+/* Free all chunks of undo records owned by "tab".
+ */
+static void free_undo_chunks(struct isl_tab *tab)
+{
+	struct isl_tab_undo_chunk *chunk, *next;
+
+	for (chunk = tab->undo_chunk; chunk; chunk = next) {
+		next = chunk->next;
+		free(chunk);
+	}
+	tab->undo_chunk = NULL;
+	tab->unused_undo = NULL;
+}
+
 void isl_tab_free(struct isl_tab *tab)
 {
 	if (!tab)
 		return;
 	free_undo(tab);
+	free_undo_chunks(tab);
 	isl_mat_free(tab->mat);
 	isl_vec_free(tab->dual);
 	isl_basic_map_free(tab->bmap);
@@ -216,6 +285,8 @@ void isl_tab_free(struct isl_tab *tab)
 	isl_mat_free(tab->samples);
 	free(tab->sample_index);
 	isl_mat_free(tab->basis);
+	free(tab->small_row);
+	free(tab->pivot_nz);
 	free(tab);
 }
 
@@ -295,6 +366,8 @@ struct isl_tab *isl_tab_dup(struct isl_tab *tab)
 	dup->bottom.type = isl_tab_undo_bottom;
 	dup->bottom.next = NULL;
 	dup->top = &dup->bottom;
+	dup->unused_undo = NULL;
+	dup->undo_chunk = NULL;
 
 	dup->n_zero = tab->n_zero;
 	dup->n_unbounded = tab->n_unbounded;
@@ -548,6 +621,8 @@ struct isl_tab *isl_tab_product(struct isl_tab *tab1, struct isl_tab *tab2)
 	prod->bottom.type = isl_tab_undo_bottom;
 	prod->bottom.next = NULL;
 	prod->top = &prod->bottom;
+	prod->unused_undo = NULL;
+	prod->undo_chunk = NULL;
 
 	prod->n_zero = 0;
 	prod->n_unbounded = 0;
@@ -685,6 +760,121 @@ static int pivot_row(struct isl_tab *tab,
 	return r;
 }
 
+/* Can column "j" be used to increase (sgn > 0) or decrease (sgn < 0)
+ * the value of the row variable with tableau row "tr"?
+ * That is, is a_rj non-zero and is either its sign equal to "sgn" or
+ * the column variable allowed to attain negative values?
+ */
+static int is_pivot_col(struct isl_tab *tab, isl_int *tr, int sgn, int j)
+{
+	if (isl_int_is_zero(tr[j]))
+		return 0;
+	if (isl_int_sgn(tr[j]) != sgn && var_from_col(tab, j)->is_nonneg)
+		return 0;
+	return 1;
+}
+
+/* Return the column with the smallest variable index among
+ * the columns that can be used to increase (sgn > 0) or
+ * decrease (sgn < 0) the value of the row variable with tableau row "tr",
+ * or -1 if there is no such column.
+ * Combined with the tie breaking in pivot_row, this corresponds
+ * to Bland's rule, which is known not to cycle.
+ */
+static int bland_col(struct isl_tab *tab, isl_int *tr, int sgn)
+{
+	int j, c;
+
+	c = -1;
+	for (j = tab->n_dead; j < tab->n_col; ++j) {
+		if (!is_pivot_col(tab, tr, sgn, j))
+			continue;
+		if (c < 0 || tab->col_var[j] < tab->col_var[c])
+			c = j;
+	}
+	return c;
+}
+
+/* Return the squared norm of column "c" of the tableau,
+ * with an implicit entry of 1 for the column variable itself.
+ * The entries are divided by the denominators of their rows.
+ */
+static double col_norm2(struct isl_tab *tab, int c)
+{
+	int i;
+	double d, a;
+	double norm2 = 1;
+	unsigned off = 2 + tab->M;
+
+	for (i = tab->n_redundant; i < tab->n_row; ++i) {
+		if (isl_int_is_zero(tab->mat->row[i][off + c]))
+			continue;
+		d = isl_int_get_d(tab->mat->row[i][0]);
+		a = isl_int_get_d(tab->mat->row[i][off + c]) / d;
+		norm2 += a * a;
+	}
+	return norm2;
+}
+
+/* Return the reference weight of the variable in column "c"
+ * for the ISL_PIVOT_DEVEX pivot rule.
+ */
+static double devex_weight(struct isl_tab *tab, int c)
+{
+	double w = var_from_col(tab, c)->weight;
+
+	return w < 1 ? 1 : w;
+}
+
+/* Return the column selected by the pivot rule "rule"
+ * among the columns that can be used to increase (sgn > 0) or
+ * decrease (sgn < 0) the value of the row variable with tableau row "tr",
+ * or -1 if there is no such column.
+ *
+ * For ISL_PIVOT_STEEPEST_EDGE and ISL_PIVOT_DEVEX, the squared coefficient
+ * of each candidate column is scaled by the squared norm of the column or
+ * by the reference weight of the column variable and the column
+ * with the greatest scaled value is selected.
+ * The computation is performed in floating point since it only
+ * affects the choice of pivot, not the result.
+ * Ties are broken in favor of the column with the smallest variable index.
+ */
+static int rule_col(struct isl_tab *tab, isl_int *tr, int sgn, int rule)
+{
+	int j, c;
+	double t, score, best = 0;
+
+	if (rule == ISL_PIVOT_BLAND)
+		return bland_col(tab, tr, sgn);
+
+	c = -1;
+	for (j = tab->n_dead; j < tab->n_col; ++j) {
+		if (!is_pivot_col(tab, tr, sgn, j))
+			continue;
+		t = isl_int_get_d(tr[j]);
+		if (rule == ISL_PIVOT_DEVEX)
+			score = t * t / devex_weight(tab, j);
+		else
+			score = t * t / col_norm2(tab, j);
+		if (c < 0 || score > best ||
+		    (score == best && tab->col_var[j] < tab->col_var[c])) {
+			c = j;
+			best = score;
+		}
+	}
+	return c;
+}
+
+/* Is pivoting on row "r" a degenerate step, i.e., is the constant term
+ * of the row equal to zero such that the sample value does not change?
+ */
+static int is_degenerate_row(struct isl_tab *tab, int r)
+{
+	if (!isl_int_is_zero(tab->mat->row[r][1]))
+		return 0;
+	return !tab->M || isl_int_is_zero(tab->mat->row[r][2]);
+}
+
 /* Find a pivot (row and col) that will increase (sgn > 0) or decrease
  * (sgn < 0) the value of row variable var.
  * If not NULL, then skip_var is a row variable that should be ignored
@@ -700,12 +890,21 @@ static int pivot_row(struct isl_tab *tab,
  * If a_ri is positive, then we need to move x_i in the same direction
  * to obtain the desired effect.  Otherwise, x_i has to move in the
  * opposite direction.
+ *
+ * The column is selected according to the pivot_rule option.
+ * If this option is not set to ISL_PIVOT_BLAND and if the selected
+ * column would result in a degenerate step, then fall back
+ * to the column selected by Bland's rule.
+ * Since every other step strictly improves the value of "var",
+ * any cycle would have to consist of steps selected by Bland's rule only,
+ * which is impossible.
  */
 static void find_pivot(struct isl_tab *tab,
 	struct isl_tab_var *var, struct isl_tab_var *skip_var,
 	int sgn, int *row, int *col)
 {
-	int j, r, c;
+	int r, c;
+	int rule;
 	isl_int *tr;
 
 	*row = *col = -1;
@@ -713,21 +912,16 @@ static void find_pivot(struct isl_tab *tab,
 	isl_assert(tab->mat->ctx, var->is_row, return);
 	tr = tab->mat->row[var->index] + 2 + tab->M;
 
-	c = -1;
-	for (j = tab->n_dead; j < tab->n_col; ++j) {
-		if (isl_int_is_zero(tr[j]))
-			continue;
-		if (isl_int_sgn(tr[j]) != sgn &&
-		    var_from_col(tab, j)->is_nonneg)
-			continue;
-		if (c < 0 || tab->col_var[j] < tab->col_var[c])
-			c = j;
-	}
+	rule = tab->mat->ctx->opt->pivot_rule;
+	c = rule_col(tab, tr, sgn, rule);
 	if (c < 0)
 		return;
 
-	sgn *= isl_int_sgn(tr[c]);
-	r = pivot_row(tab, skip_var, sgn, c);
+	r = pivot_row(tab, skip_var, sgn * isl_int_sgn(tr[c]), c);
+	if (r >= 0 && rule != ISL_PIVOT_BLAND && is_degenerate_row(tab, r)) {
+		c = bland_col(tab, tr, sgn);
+		r = pivot_row(tab, skip_var, sgn * isl_int_sgn(tr[c]), c);
+	}
 	*row = r < 0 ? var->index : r;
 	*col = c;
 }
@@ -797,7 +991,7 @@ static int push_union(struct isl_tab *tab,
 	if (!tab->need_undo)
 		return 0;
 
-	undo = isl_alloc_type(tab->mat->ctx, struct isl_tab_undo);
+	undo = alloc_undo_record(tab);
 	if (!undo)
 		return -1;
 	undo->type = type;
@@ -1058,6 +1252,243 @@ static void update_row_sign(struct isl_tab *tab, int row, int col, int row_sgn)
 	}
 }
 
+#ifdef __SIZEOF_INT128__
+
+/* Does "v" fit in a long with absolute value at most LONG_MAX?
+ * LONG_MIN is excluded such that the sum of two products
+ * of such values is guaranteed to fit in an __int128.
+ */
+static int fits_small(isl_int v)
+{
+	return isl_int_fits_slong(v) && isl_int_cmp_si(v, LONG_MIN) != 0;
+}
+
+/* Does "v" fit in a long with absolute value at most LONG_MAX?
+ */
+static int wide_fits_small(__int128 v)
+{
+	return v >= -LONG_MAX && v <= LONG_MAX;
+}
+
+/* Return the greatest common divisor of "a" and "b".
+ */
+static unsigned long gcd_ul(unsigned long a, unsigned long b)
+{
+	while (b) {
+		unsigned long t = a % b;
+		a = b;
+		b = t;
+	}
+	return a;
+}
+
+/* Load the (already transformed) pivot row "row" into the first half
+ * of tab->small_row, allocating the scratch buffer if needed.
+ * The second half is used by pivot_row_small to store
+ * the updated version of another row.
+ *
+ * Return 1 if all entries of the pivot row fit in a long,
+ * 0 if they do not and -1 on error.
+ */
+static int load_small_pivot_row(struct isl_tab *tab, int row)
+{
+	int j;
+	unsigned len = 2 + tab->M + tab->n_col;
+	isl_int *r = tab->mat->row[row];
+
+	for (j = 0; j < len; ++j)
+		if (!fits_small(r[j]))
+			return 0;
+
+	if (tab->small_size < 2 * len) {
+		long *small_row;
+
+		small_row = isl_realloc_array(isl_tab_get_ctx(tab),
+					tab->small_row, long, 2 * len);
+		if (!small_row)
+			return -1;
+		tab->small_row = small_row;
+		tab->small_size = 2 * len;
+	}
+
+	for (j = 0; j < len; ++j)
+		tab->small_row[j] = isl_int_get_si(r[j]);
+
+	return 1;
+}
+
+/* Update row "i" of "tab" for a pivot on column "col" using native
+ * arithmetic, given the transformed pivot row stored in the first half
+ * of tab->small_row by load_small_pivot_row.
+ * This performs the same computation as the generic code
+ * in isl_tab_pivot, including the final normalization,
+ * but with 128-bit intermediate results.
+ * The updated row is first computed in the second half of tab->small_row
+ * and it is only written back if none of the entries
+ * of the original or the updated row overflows a long.
+ *
+ * Return 1 if row "i" has been updated and 0 if it has been left untouched,
+ * in which case the caller should fall back to isl_int arithmetic.
+ */
+static int pivot_row_small(struct isl_tab *tab, int i, int col)
+{
+	int j;
+	unsigned off = 2 + tab->M;
+	unsigned len = off + tab->n_col;
+	isl_int *row_i = tab->mat->row[i];
+	long *r = tab->small_row;
+	long *res = tab->small_row + len;
+	long a_c;
+	unsigned long g = 0;
+
+	if (!fits_small(row_i[off + col]))
+		return 0;
+	a_c = isl_int_get_si(row_i[off + col]);
+	for (j = 0; j < len; ++j) {
+		long a;
+		__int128 v;
+
+		if (!fits_small(row_i[j]))
+			return 0;
+		a = isl_int_get_si(row_i[j]);
+		if (j == off + col)
+			v = (__int128) a * r[j];
+		else if (j == 0)
+			v = (__int128) a * r[0];
+		else
+			v = (__int128) a * r[0] + (__int128) a_c * r[j];
+		if (!wide_fits_small(v))
+			return 0;
+		res[j] = (long) v;
+		if (g != 1 && res[j] != 0)
+			g = gcd_ul(res[j] < 0 ? -(unsigned long) res[j] : res[j],
+				   g);
+	}
+
+	if (res[0] != 1 && g > 1)
+		for (j = 0; j < len; ++j)
+			res[j] /= (long) g;
+	for (j = 0; j < len; ++j)
+		isl_int_set_si(row_i[j], res[j]);
+
+	return 1;
+}
+
+#else
+
+static int load_small_pivot_row(struct isl_tab *tab, int row)
+{
+	return 0;
+}
+
+static int pivot_row_small(struct isl_tab *tab, int i, int col)
+{
+	return 0;
+}
+
+#endif
+
+/* Store the positions of the non-zero entries of the (already transformed)
+ * pivot row "row" in tab->pivot_nz, allocating the scratch buffer
+ * if needed.  The position of the denominator and that of
+ * the pivot column "col" are skipped.
+ *
+ * Return the number of such entries or -1 on error.
+ */
+static int collect_pivot_row_non_zero(struct isl_tab *tab, int row, int col)
+{
+	int j, n;
+	unsigned off = 2 + tab->M;
+	unsigned len = off + tab->n_col;
+	isl_int *r = tab->mat->row[row];
+
+	if (tab->pivot_nz_size < len) {
+		int *pivot_nz;
+
+		pivot_nz = isl_realloc_array(isl_tab_get_ctx(tab),
+					tab->pivot_nz, int, len);
+		if (!pivot_nz)
+			return -1;
+		tab->pivot_nz = pivot_nz;
+		tab->pivot_nz_size = len;
+	}
+
+	for (j = 1, n = 0; j < len; ++j) {
+		if (j == off + col)
+			continue;
+		if (!isl_int_is_zero(r[j]))
+			tab->pivot_nz[n++] = j;
+	}
+
+	return n;
+}
+
+/* Update row "i" of "tab" for a pivot on row "row" and column "col",
+ * given the positions of the "n" non-zero entries of the (transformed)
+ * pivot row, other than the denominator and the pivot column,
+ * in tab->pivot_nz.
+ * This performs the same computation as the generic code
+ * in isl_tab_pivot, except for the final normalization,
+ * but it only looks at the entries in the pivot row that may
+ * contribute something.  The other entries of row "i" only need
+ * to be multiplied by the denominator of the pivot row,
+ * which can be skipped if this denominator is one.
+ */
+static void pivot_row_sparse(struct isl_tab *tab, int i, int row, int col,
+	int n)
+{
+	int j, k;
+	unsigned off = 2 + tab->M;
+	isl_int *row_i = tab->mat->row[i];
+	isl_int *r = tab->mat->row[row];
+
+	if (!isl_int_is_one(r[0])) {
+		for (j = 0; j < off + tab->n_col; ++j) {
+			if (j == off + col || isl_int_is_zero(row_i[j]))
+				continue;
+			isl_int_mul(row_i[j], row_i[j], r[0]);
+		}
+	}
+	for (k = 0; k < n; ++k) {
+		j = tab->pivot_nz[k];
+		isl_int_addmul(row_i[j], row_i[off + col], r[j]);
+	}
+	isl_int_mul(row_i[off + col], row_i[off + col], r[off + col]);
+}
+
+/* Update the reference weights of the ISL_PIVOT_DEVEX pivot rule
+ * for a pivot on row "row" and column "col", before the pivot is performed.
+ *
+ * Let x_q be the variable in column "col" and let the row be of the form
+ *
+ *	x_r = a_r0/d_r + \sum_j a_rj/d_r x_j
+ *
+ * The weight w_j of any other column variable x_j is updated to
+ * max(w_j, (a_rj/a_rq)^2 w_q), while x_r, which becomes a column
+ * variable, receives weight max(w_q (d_r/a_rq)^2, 1).
+ */
+static void update_devex_weights(struct isl_tab *tab, int row, int col)
+{
+	int j;
+	double d, a, w, wq, t;
+	isl_int *r = tab->mat->row[row];
+	unsigned off = 2 + tab->M;
+
+	d = isl_int_get_d(r[0]);
+	a = isl_int_get_d(r[off + col]);
+	wq = devex_weight(tab, col);
+	for (j = tab->n_dead; j < tab->n_col; ++j) {
+		if (j == col || isl_int_is_zero(r[off + j]))
+			continue;
+		t = isl_int_get_d(r[off + j]) / a;
+		w = t * t * wq;
+		if (w > var_from_col(tab, j)->weight)
+			var_from_col(tab, j)->weight = w;
+	}
+	w = wq * (d / a) * (d / a);
+	isl_tab_var_from_row(tab, row)->weight = w < 1 ? 1 : w;
+}
+
 /* Given a row number "row" and a column number "col", pivot the tableau
  * such that the associated variables are interchanged.
  * The given row in the tableau expresses
@@ -1107,12 +1538,18 @@ static void update_row_sign(struct isl_tab *tab, int row, int col, int row_sgn)
  * s(n_rc)d_r/|n_rc|		-s(n_rc)n_ri/|n_rc|
  * s(n_rc)d_r n_jc/(|n_rc| d_j)	(n_ji |n_rc| - s(n_rc)n_jc n_ri)/(|n_rc| d_j)
  *
+ * If all entries of the transformed pivot row fit in a long, then
+ * the other rows are first updated using native arithmetic
+ * (see pivot_row_small), falling back to isl_int arithmetic
+ * for those rows where some entry would overflow.
  */
 int isl_tab_pivot(struct isl_tab *tab, int row, int col)
 {
 	int i, j;
 	int sgn;
 	int t;
+	int small;
+	int n_nz, sparse;
 	isl_ctx *ctx;
 	struct isl_mat *mat = tab->mat;
 	struct isl_tab_var *var;
@@ -1121,6 +1558,9 @@ int isl_tab_pivot(struct isl_tab *tab, int row, int col)
 	ctx = isl_tab_get_ctx(tab);
 	if (isl_ctx_next_operation(ctx) < 0)
 		return -1;
+	isl_ctx_count_pivot(ctx, is_degenerate_row(tab, row));
+	if (!tab->in_undo && ctx->opt->pivot_rule == ISL_PIVOT_DEVEX)
+		update_devex_weights(tab, row, col);
 
 	isl_int_swap(mat->row[row][0], mat->row[row][off + col]);
 	sgn = isl_int_sgn(mat->row[row][0]);
@@ -1135,22 +1575,37 @@ int isl_tab_pivot(struct isl_tab *tab, int row, int col)
 		}
 	if (!isl_int_is_one(mat->row[row][0]))
 		isl_seq_normalize(mat->ctx, mat->row[row], off + tab->n_col);
+	small = load_small_pivot_row(tab, row);
+	if (small < 0)
+		return -1;
+	n_nz = collect_pivot_row_non_zero(tab, row, col);
+	if (n_nz < 0)
+		return -1;
+	sparse = 2 * n_nz < off - 1 + tab->n_col;
 	for (i = 0; i < tab->n_row; ++i) {
 		if (i == row)
 			continue;
 		if (isl_int_is_zero(mat->row[i][off + col]))
 			continue;
-		isl_int_mul(mat->row[i][0], mat->row[i][0], mat->row[row][0]);
-		for (j = 0; j < off - 1 + tab->n_col; ++j) {
-			if (j == off - 1 + col)
-				continue;
-			isl_int_mul(mat->row[i][1 + j],
+		if (small && pivot_row_small(tab, i, col))
+			continue;
+		if (sparse) {
+			pivot_row_sparse(tab, i, row, col, n_nz);
+		} else {
+			isl_int_mul(mat->row[i][0],
+				    mat->row[i][0], mat->row[row][0]);
+			for (j = 0; j < off - 1 + tab->n_col; ++j) {
+				if (j == off - 1 + col)
+					continue;
+				isl_int_mul(mat->row[i][1 + j],
 				    mat->row[i][1 + j], mat->row[row][0]);
-			isl_int_addmul(mat->row[i][1 + j],
-				    mat->row[i][off + col], mat->row[row][1 + j]);
-		}
-		isl_int_mul(mat->row[i][off + col],
+				isl_int_addmul(mat->row[i][1 + j],
+				    mat->row[i][off + col],
+				    mat->row[row][1 + j]);
+			}
+			isl_int_mul(mat->row[i][off + col],
 			    mat->row[i][off + col], mat->row[row][off + col]);
+		}
 		if (!isl_int_is_one(mat->row[i][0]))
 			isl_seq_normalize(mat->ctx, mat->row[i], off + tab->n_col);
 	}
@@ -1675,6 +2130,7 @@ int isl_tab_allocate_con(struct isl_tab *tab)
 	tab->con[r].is_redundant = 0;
 	tab->con[r].frozen = 0;
 	tab->con[r].negated = 0;
+	tab->con[r].weight = 1;
 	tab->row_var[tab->n_row] = ~r;
 
 	tab->n_row++;
@@ -1761,6 +2217,7 @@ int isl_tab_insert_var(struct isl_tab *tab, int r)
 	tab->var[r].is_redundant = 0;
 	tab->var[r].frozen = 0;
 	tab->var[r].negated = 0;
+	tab->var[r].weight = 1;
 	tab->col_var[tab->n_col] = r;
 
 	for (i = 0; i < tab->n_row; ++i)
@@ -2673,6 +3130,7 @@ static isl_stat cut_to_hyperplane(struct isl_tab *tab, struct isl_tab_var *var)
 	tab->con[r].is_redundant = 0;
 	tab->con[r].frozen = 0;
 	tab->con[r].negated = 0;
+	tab->con[r].weight = 1;
 	tab->row_var[tab->n_row] = ~r;
 	row = tab->mat->row[tab->n_row];
 
@@ -3192,6 +3650,285 @@ int isl_tab_is_equality(struct isl_tab *tab, int con)
 					tab->n_col - tab->n_dead) == -1;
 }
 
+/* Tolerance used by the double precision simplex in double_simplex.
+ */
+#define ISL_TAB_DOUBLE_EPS	1e-9
+
+static int restore_basis(struct isl_tab *tab, int *col_var);
+
+/* Return the position of the variable or constraint "v",
+ * as stored in tab->row_var or tab->col_var, in a numbering
+ * of all variables followed by all constraints.
+ */
+static int var_pos(struct isl_tab *tab, int v)
+{
+	return v >= 0 ? v : tab->n_var + ~v;
+}
+
+static double abs_d(double v)
+{
+	return v < 0 ? -v : v;
+}
+
+/* Perform a pivot on row "r" and column "c" of the "n_row" by "1 + n_col"
+ * double precision tableau "d" with row and column variables
+ * "row_var" and "col_var".
+ * The rows have the same form as those of an isl_tab, except that
+ * there is no denominator.
+ */
+static void double_pivot(double *d, int n_row, int n_col,
+	int *row_var, int *col_var, int r, int c)
+{
+	int i, j, t;
+	double *dr = d + r * (1 + n_col);
+	double a = dr[1 + c];
+
+	for (j = 0; j < 1 + n_col; ++j)
+		dr[j] = j == 1 + c ? 1 / a : -dr[j] / a;
+	for (i = 0; i < n_row; ++i) {
+		double *di = d + i * (1 + n_col);
+		double b = di[1 + c];
+
+		if (i == r || b == 0)
+			continue;
+		for (j = 0; j < 1 + n_col; ++j)
+			if (j != 1 + c)
+				di[j] += b * dr[j];
+		di[1 + c] = b * dr[1 + c];
+	}
+	t = row_var[r];
+	row_var[r] = col_var[c];
+	col_var[c] = t;
+}
+
+/* Minimize the row variable "obj" of "tab" using a simplex method
+ * on a double precision copy of the non-redundant rows and
+ * the non-dead columns of "tab" and mark the variables
+ * that are basic in the final tableau in "basic",
+ * indexed by var_pos.
+ * The entering column is selected as the one with the largest
+ * coefficient in the objective row.
+ *
+ * Return 1 if an optimal basis was found, 0 if the minimum appears
+ * to be unbounded or if no optimal basis was found
+ * within a reasonable number of iterations and -1 on error.
+ * Since the computation is not exact, the result is only
+ * an approximation of an optimal basis.
+ */
+static int double_simplex(struct isl_tab *tab, struct isl_tab_var *obj,
+	char *basic)
+{
+	int i, j, r, c, it, max_it;
+	int n_row, n_col, o;
+	int found = 0;
+	double *d;
+	int *row_var, *col_var;
+	isl_ctx *ctx = isl_tab_get_ctx(tab);
+	unsigned off = 2 + tab->M;
+
+	n_row = tab->n_row - tab->n_redundant;
+	n_col = tab->n_col - tab->n_dead;
+	o = obj->index - tab->n_redundant;
+	d = isl_alloc_array(ctx, double, n_row * (1 + n_col));
+	row_var = isl_alloc_array(ctx, int, n_row);
+	col_var = isl_alloc_array(ctx, int, n_col);
+	if ((n_row && !d) || (n_row && !row_var) ||
+	    (n_col && !col_var))
+		goto error;
+
+	for (i = 0; i < n_row; ++i) {
+		isl_int *row = tab->mat->row[tab->n_redundant + i];
+		double den = isl_int_get_d(row[0]);
+		double *di = d + i * (1 + n_col);
+
+		row_var[i] = tab->row_var[tab->n_redundant + i];
+		di[0] = isl_int_get_d(row[1]) / den;
+		for (j = 0; j < n_col; ++j)
+			di[1 + j] = isl_int_get_d(row[off + tab->n_dead + j]) / den;
+	}
+	for (j = 0; j < n_col; ++j)
+		col_var[j] = tab->col_var[tab->n_dead + j];
+
+	max_it = 10 * (n_row + n_col);
+	for (it = 0; it < max_it; ++it) {
+		double *dobj = d + o * (1 + n_col);
+		double t, best, sgn;
+
+		c = -1;
+		best = ISL_TAB_DOUBLE_EPS;
+		for (j = 0; j < n_col; ++j) {
+			t = dobj[1 + j];
+			if (t > 0 && var_from_index(tab, col_var[j])->is_nonneg)
+				continue;
+			if (abs_d(t) > best) {
+				c = j;
+				best = abs_d(t);
+			}
+		}
+		if (c < 0) {
+			found = 1;
+			break;
+		}
+		sgn = dobj[1 + c] < 0 ? 1 : -1;
+		r = -1;
+		best = 0;
+		for (i = 0; i < n_row; ++i) {
+			double *di = d + i * (1 + n_col);
+			double a = sgn * di[1 + c];
+			double bound;
+
+			if (i == o || a >= -ISL_TAB_DOUBLE_EPS)
+				continue;
+			if (!var_from_index(tab, row_var[i])->is_nonneg)
+				continue;
+			bound = di[0] > 0 ? di[0] / -a : 0;
+			if (r < 0 || bound < best) {
+				r = i;
+				best = bound;
+			}
+		}
+		if (r < 0)
+			break;
+		double_pivot(d, n_row, n_col, row_var, col_var, r, c);
+	}
+
+	if (found) {
+		for (i = 0; i < tab->n_redundant; ++i)
+			basic[var_pos(tab, tab->row_var[i])] = 1;
+		for (i = 0; i < n_row; ++i)
+			basic[var_pos(tab, row_var[i])] = 1;
+	}
+
+	free(d);
+	free(row_var);
+	free(col_var);
+	return found;
+error:
+	free(d);
+	free(row_var);
+	free(col_var);
+	return -1;
+}
+
+/* Is the sample value of "tab" feasible, i.e., are all the non-redundant
+ * rows that represent non-negative variables non-negative?
+ * This function assumes that tab->M is not set.
+ */
+static int sample_is_feasible(struct isl_tab *tab)
+{
+	int i;
+
+	for (i = tab->n_redundant; i < tab->n_row; ++i) {
+		if (!isl_tab_var_from_row(tab, i)->is_nonneg)
+			continue;
+		if (isl_int_is_neg(tab->mat->row[i][1]))
+			return 0;
+	}
+	return 1;
+}
+
+/* Pivot the variables that are marked in "basic" into the rows of "tab",
+ * in as far as this is possible without involving the redundant rows or
+ * the dead columns.
+ *
+ * The pivots are performed in "in_undo" mode such that
+ * they do not mark any rows as redundant.
+ * The resulting tableau is therefore not necessarily feasible
+ * and it can be moved back to its original basis using restore_basis.
+ *
+ * Return the number of pivots performed or -1 on error.
+ */
+static int move_to_basis(struct isl_tab *tab, char *basic)
+{
+	int i, c;
+	int n = 0;
+	unsigned off = 2 + tab->M;
+
+	tab->in_undo = 1;
+	for (c = tab->n_dead; c < tab->n_col; ++c) {
+		if (!basic[var_pos(tab, tab->col_var[c])])
+			continue;
+		for (i = tab->n_redundant; i < tab->n_row; ++i) {
+			if (basic[var_pos(tab, tab->row_var[i])])
+				continue;
+			if (!isl_int_is_zero(tab->mat->row[i][off + c]))
+				break;
+		}
+		if (i >= tab->n_row)
+			continue;
+		if (isl_tab_pivot(tab, i, c) < 0) {
+			n = -1;
+			break;
+		}
+		n++;
+	}
+	tab->in_undo = 0;
+
+	return n;
+}
+
+/* Try and move "tab" to a basis that is optimal for minimizing
+ * the row variable "obj", using the lp_double_start option.
+ *
+ * The basis is first computed in double precision by double_simplex.
+ * The tableau is then moved to this basis using exact pivots.
+ * If the resulting sample value is not feasible, e.g., because
+ * of rounding errors, then the tableau is moved back to its original basis.
+ * Either way, the caller still needs to perform the usual exact
+ * pivots until an optimum is reached, which certifies
+ * the optimality of the basis.
+ * Tableaus with a big parameter are left untouched.
+ * The statistics keep track of how often the tableau
+ * is effectively moved to a different basis.
+ */
+static int double_start(struct isl_tab *tab, struct isl_tab_var *obj)
+{
+	int i, n, found;
+	char *basic;
+	int *col_var = NULL;
+	isl_ctx *ctx = isl_tab_get_ctx(tab);
+
+	if (tab->M || !obj->is_row)
+		return 0;
+
+	basic = isl_calloc_array(ctx, char, tab->n_var + tab->n_con);
+	if (!basic)
+		return -1;
+	found = double_simplex(tab, obj, basic);
+	if (found <= 0) {
+		free(basic);
+		return found;
+	}
+
+	col_var = isl_alloc_array(ctx, int, tab->n_col);
+	if (tab->n_col && !col_var)
+		goto error;
+	for (i = 0; i < tab->n_col; ++i)
+		col_var[i] = tab->col_var[i];
+	n = move_to_basis(tab, basic);
+	if (n < 0)
+		goto error;
+	if (n > 0 && sample_is_feasible(tab))
+		isl_ctx_count_double_start(ctx);
+	else if (n > 0) {
+		int r;
+
+		tab->in_undo = 1;
+		r = restore_basis(tab, col_var);
+		tab->in_undo = 0;
+		if (r < 0)
+			goto error;
+	}
+
+	free(col_var);
+	free(basic);
+	return 0;
+error:
+	free(col_var);
+	free(basic);
+	return -1;
+}
+
 /* Return the minimal value of the affine expression "f" with denominator
  * "denom" in *opt, *opt_denom, assuming the tableau is not empty and
  * the expression cannot attain arbitrarily small values.
@@ -3201,6 +3938,9 @@ int isl_tab_is_equality(struct isl_tab *tab, int con)
  *
  * This function assumes that at least one more row and at least
  * one more element in the constraint array are available in the tableau.
+ *
+ * If the lp_double_start option is set, then the tableau is first
+ * moved to an approximately optimal basis computed in double precision.
  */
 enum isl_lp_result isl_tab_min(struct isl_tab *tab,
 	isl_int *f, isl_int denom, isl_int *opt, isl_int *opt_denom,
@@ -3222,6 +3962,8 @@ enum isl_lp_result isl_tab_min(struct isl_tab *tab,
 	if (r < 0)
 		return isl_lp_error;
 	var = &tab->con[r];
+	if (tab->mat->ctx->opt->lp_double_start && double_start(tab, var) < 0)
+		return isl_lp_error;
 	for (;;) {
 		int row, col;
 		find_pivot(tab, var, var, -1, &row, &col);
@@ -3642,7 +4384,7 @@ int isl_tab_rollback(struct isl_tab *tab, struct isl_tab_undo *snap)
 			tab->in_undo = 0;
 			return -1;
 		}
-		free_undo_record(undo);
+		free_undo_record(tab, undo);
 	}
 	tab->in_undo = 0;
 	tab->top = undo;
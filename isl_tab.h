@@ -16,6 +16,9 @@
 #include <isl/set.h>
 #include <isl_config.h>
 
+/* "weight" is the reference weight of the variable
+ * for the ISL_PIVOT_DEVEX pivot rule.
+ */
 struct isl_tab_var {
 	int index;
 	unsigned is_row : 1;
@@ -25,6 +28,7 @@ struct isl_tab_var {
 	unsigned marked : 1;
 	unsigned frozen : 1;
 	unsigned negated : 1;
+	double weight;
 };
 
 enum isl_tab_undo_type {
@@ -64,6 +68,8 @@ struct isl_tab_undo {
 	struct isl_tab_undo	*next;
 };
 
+struct isl_tab_undo_chunk;
+
 /* The tableau maintains equality relations.
  * Each column and each row is associated to a variable or a constraint.
  * The "value" of an inequality constraint is the value of the corresponding
@@ -124,6 +130,15 @@ struct isl_tab_undo {
  *
  * If "preserve" is set, then we want to keep all constraints in the
  * tableau, even if they turn out to be redundant.
+ *
+ * "small_row" is a scratch buffer of "small_size" elements that is
+ * used by isl_tab_pivot to update rows with coefficients that fit
+ * in a long using native arithmetic.  It is allocated on demand.
+ *
+ * The records on the undo stack, starting at "top", are taken
+ * from the chunks in the "undo_chunk" list, which are owned
+ * by the tableau.  Records that have been popped off the stack
+ * are kept in the "unused_undo" list for later reuse.
  */
 enum isl_tab_row_sign {
 	isl_tab_row_unknown = 0,
@@ -154,6 +169,8 @@ struct isl_tab {
 
 	struct isl_tab_undo bottom;
 	struct isl_tab_undo *top;
+	struct isl_tab_undo *unused_undo;
+	struct isl_tab_undo_chunk *undo_chunk;
 
 	struct isl_vec *dual;
 	struct isl_basic_map *bmap;
@@ -170,6 +187,12 @@ struct isl_tab {
 	int (*conflict)(int con, void *user);
 	void *conflict_user;
 
+	long *small_row;
+	unsigned small_size;
+
+	int *pivot_nz;
+	unsigned pivot_nz_size;
+
 	unsigned strict_redundant : 1;
 	unsigned need_undo : 1;
 	unsigned preserve : 1;
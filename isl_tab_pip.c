@@ -22,6 +22,9 @@
 #include <isl_constraint_private.h>
 #include <isl_options_private.h>
 #include <isl_config.h>
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
 
 #include <bset_to_bmap.c>
 
@@ -162,12 +165,21 @@ struct isl_sol_callback {
  *
  * The context tableau is owned by isl_sol and is updated incrementally.
  *
- * There are currently two implementations of this interface,
+ * There are currently three implementations of this interface,
  * isl_sol_map, which simply collects the solutions in an isl_map
  * and (optionally) the parts of the context where there is no solution
- * in an isl_set, and
+ * in an isl_set,
+ * isl_sol_pma, which does the same using an isl_pw_multi_aff, and
  * isl_sol_for, which calls a user-defined function for each part of
  * the solution.
+ *
+ * If "fork" is not NULL, then parts of the context may be solved
+ * in separate threads.  "fork" then creates an isl_sol of the same type
+ * without a context, which collects the solutions of such a part, and
+ * "join" adds the solutions collected in such an isl_sol to "sol".
+ * "threads" contains the threads that were started from "sol" and
+ * "depth" is the number of context splits that led to the part
+ * of the context that is currently being solved.
  */
 struct isl_sol {
 	int error;
@@ -175,20 +187,28 @@ struct isl_sol {
 	int level;
 	int max;
 	int n_out;
+	int depth;
 	struct isl_context *context;
 	struct isl_partial_sol *partial;
 	void (*add)(struct isl_sol *sol,
 			    struct isl_basic_set *dom, struct isl_mat *M);
 	void (*add_empty)(struct isl_sol *sol, struct isl_basic_set *bset);
 	void (*free)(struct isl_sol *sol);
+	struct isl_sol *(*fork)(struct isl_sol *sol);
+	void (*join)(struct isl_sol *sol, struct isl_sol *child);
+	struct isl_sol_thread *threads;
 	struct isl_sol_callback	dec_level;
 };
 
+static void sol_join_threads(struct isl_sol *sol);
+static void sol_free_threads(struct isl_sol *sol);
+
 static void sol_free(struct isl_sol *sol)
 {
 	struct isl_partial_sol *partial, *next;
 	if (!sol)
 		return;
+	sol_free_threads(sol);
 	for (partial = sol->partial; partial; partial = next) {
 		next = partial->next;
 		isl_basic_set_free(partial->dom);
@@ -405,6 +425,26 @@ static void sol_inc_level(struct isl_sol *sol)
 		sol->error = 1;
 }
 
+/* Initialize the fields of "child", which has been created
+ * by sol->fork, that are shared by all types of isl_sol,
+ * except for the context, which is set by the thread
+ * that computes the solutions in "child".
+ */
+static void sol_init_fork(struct isl_sol *child, struct isl_sol *sol)
+{
+	child->rational = sol->rational;
+	child->max = sol->max;
+	child->n_out = sol->n_out;
+	child->depth = sol->depth;
+	child->add = sol->add;
+	child->add_empty = sol->add_empty;
+	child->free = sol->free;
+	child->fork = sol->fork;
+	child->join = sol->join;
+	child->dec_level.callback.run = &sol_dec_level_wrap;
+	child->dec_level.sol = child;
+}
+
 static void scale_rows(struct isl_mat *mat, isl_int m, int n_row)
 {
 	int i;
@@ -705,6 +745,58 @@ static void sol_map_add_wrap(struct isl_sol *sol,
 	sol_map_add((struct isl_sol_map *)sol, dom, M);
 }
 
+/* Create an isl_sol_map for collecting the solutions of a part
+ * of the context of "sol" in a separate thread.
+ */
+static struct isl_sol *sol_map_fork(struct isl_sol *sol)
+{
+	struct isl_sol_map *sol_map = (struct isl_sol_map *) sol;
+	struct isl_sol_map *fork;
+
+	fork = isl_calloc_type(isl_map_get_ctx(sol_map->map),
+				struct isl_sol_map);
+	if (!fork)
+		return NULL;
+
+	sol_init_fork(&fork->sol, sol);
+	fork->map = isl_map_alloc_space(isl_map_get_space(sol_map->map), 1,
+					ISL_MAP_DISJOINT);
+	if (!fork->map)
+		goto error;
+	if (sol_map->empty) {
+		fork->empty = isl_set_alloc_space(
+			isl_set_get_space(sol_map->empty), 1, ISL_SET_DISJOINT);
+		if (!fork->empty)
+			goto error;
+	}
+
+	return &fork->sol;
+error:
+	sol_map_free(fork);
+	return NULL;
+}
+
+/* Add the solutions collected in "child" to those in "sol".
+ * Since "child" collects the solutions of a part of the context
+ * that is disjoint from the rest, the results are disjoint as well.
+ */
+static void sol_map_join(struct isl_sol *sol, struct isl_sol *child)
+{
+	struct isl_sol_map *sol_map = (struct isl_sol_map *) sol;
+	struct isl_sol_map *child_map = (struct isl_sol_map *) child;
+
+	sol_map->map = isl_map_union_disjoint(sol_map->map,
+					isl_map_copy(child_map->map));
+	if (!sol_map->map)
+		sol->error = 1;
+	if (!sol_map->empty)
+		return;
+	sol_map->empty = isl_set_union_disjoint(sol_map->empty,
+					isl_set_copy(child_map->empty));
+	if (!sol_map->empty)
+		sol->error = 1;
+}
+
 
 /* Store the "parametric constant" of row "row" of tableau "tab" in "line",
  * i.e., the constant term and the coefficients of all variables that
@@ -801,18 +893,20 @@ static struct isl_vec *get_row_parameter_ineq(struct isl_tab *tab, int row)
  */
 static void normalize_div(__isl_keep isl_vec *div)
 {
-	isl_ctx *ctx = isl_vec_get_ctx(div);
 	int len = div->size - 2;
+	isl_int local, *gcd;
+	isl_ctx *ctx = isl_vec_get_ctx(div);
 
-	isl_seq_gcd(div->el + 2, len, &ctx->normalize_gcd);
-	isl_int_gcd(ctx->normalize_gcd, ctx->normalize_gcd, div->el[0]);
+	gcd = isl_ctx_get_normalize_gcd(ctx, &local);
+	isl_seq_gcd(div->el + 2, len, gcd);
+	isl_int_gcd(*gcd, *gcd, div->el[0]);
 
-	if (isl_int_is_one(ctx->normalize_gcd))
-		return;
-
-	isl_int_divexact(div->el[0], div->el[0], ctx->normalize_gcd);
-	isl_int_fdiv_q(div->el[1], div->el[1], ctx->normalize_gcd);
-	isl_seq_scale_down(div->el + 2, div->el + 2, ctx->normalize_gcd, len);
+	if (!isl_int_is_one(*gcd)) {
+		isl_int_divexact(div->el[0], div->el[0], *gcd);
+		isl_int_fdiv_q(div->el[1], div->el[1], *gcd);
+		isl_seq_scale_down(div->el + 2, div->el + 2, *gcd, len);
+	}
+	isl_ctx_release_normalize_gcd(ctx, gcd);
 }
 
 /* Return an integer division for use in a parametric cut based
@@ -3491,6 +3585,8 @@ static struct isl_sol *sol_map_init(struct isl_basic_map *bmap,
 	sol_map->sol.add = &sol_map_add_wrap;
 	sol_map->sol.add_empty = track_empty ? &sol_map_add_empty_wrap : NULL;
 	sol_map->sol.free = &sol_map_free_wrap;
+	sol_map->sol.fork = &sol_map_fork;
+	sol_map->sol.join = &sol_map_join;
 	sol_map->map = isl_map_alloc_space(isl_basic_map_get_space(bmap), 1,
 					    ISL_MAP_DISJOINT);
 	if (!sol_map->map)
@@ -3687,13 +3783,214 @@ error:
 }
 
 static void find_solutions(struct isl_sol *sol, struct isl_tab *tab);
+static void find_solutions_top(struct isl_sol *sol, struct isl_tab *tab);
+
+/* A thread that computes the solutions of a part of the context
+ * of the isl_sol from which it was started in the separate isl_sol "sol".
+ * "sol" is created by the fork callback of the original isl_sol,
+ * while its context is created by the thread itself from "dom",
+ * which has "n_unknown" final unknown integer divisions,
+ * after which the constraint "ineq" is added to this context.
+ * "tab" is the main tableau from which the computation starts.
+ * "started" is set if the computation is performed by a separate thread,
+ * identified by "thread".
+ * "next" is the next thread that was started from the same isl_sol.
+ */
+struct isl_sol_thread {
+#ifdef HAVE_PTHREAD
+	pthread_t thread;
+#endif
+	int started;
+
+	struct isl_sol *sol;
+	isl_basic_set *dom;
+	int n_unknown;
+	isl_vec *ineq;
+	struct isl_tab *tab;
+
+	struct isl_sol_thread *next;
+};
+
+static void sol_thread_free(struct isl_sol_thread *thread)
+{
+	sol_free(thread->sol);
+	isl_basic_set_free(thread->dom);
+	isl_vec_free(thread->ineq);
+	isl_tab_free(thread->tab);
+	free(thread);
+}
+
+/* Compute the solutions of the part of the context described by "user",
+ * which is an isl_sol_thread.
+ * The newly created context does not have the samples of the context
+ * of the isl_sol from which the thread was started, so a sample
+ * satisfying the added constraint needs to be looked for explicitly.
+ * The solutions of any part of this context that is handed off
+ * to yet another thread are added to thread->sol by sol_join_threads.
+ */
+static void *sol_thread_run(void *user)
+{
+	struct isl_sol_thread *thread = user;
+	struct isl_sol *sol = thread->sol;
+	struct isl_context *context;
+
+	context = isl_context_alloc(thread->dom);
+	thread->dom = isl_basic_set_free(thread->dom);
+	sol->context = context;
+	if (!context)
+		goto error;
+	context->n_unknown = thread->n_unknown;
+	context->op->add_ineq(context, thread->ineq->el, 1, 1);
+	if (!context->op->is_ok(context))
+		goto error;
+
+	find_solutions_top(sol, thread->tab);
+	thread->tab = NULL;
+	sol_join_threads(sol);
+
+	return NULL;
+error:
+	sol->error = 1;
+	return NULL;
+}
+
+/* Should the part of the context of "sol" where a constraint
+ * is added to the context be solved in a separate thread?
+ *
+ * This is only possible if "sol" supports collecting the solutions
+ * of a part of the context separately and if the isl_ctx
+ * is in thread-safe mode.  Since the result may depend on whether
+ * or not a part of the context is solved separately, the decision
+ * only depends on the nesting depth of the context split.
+ * Since sol->depth already includes the current split,
+ * at most pip_parallel_depth splits along any path are solved
+ * in a separate thread.
+ */
+static int sol_fork_split(struct isl_sol *sol, struct isl_tab *tab)
+{
+#ifdef HAVE_PTHREAD
+	isl_ctx *ctx;
+
+	if (!sol->fork)
+		return 0;
+	ctx = tab->mat->ctx;
+	if (!isl_ctx_is_thread_safe(ctx))
+		return 0;
+	return sol->depth <= ctx->opt->pip_parallel_depth;
+#else
+	return 0;
+#endif
+}
+
+/* Start a thread for computing the solutions for values
+ * of the parameters that satisfy the given inequality
+ * on a copy of the main tableau "tab".
+ *
+ * Everything the thread needs from "sol" is extracted
+ * before the thread is started, such that "sol" can be modified
+ * while the thread is running.
+ * Since only isl_space objects may be shared between threads,
+ * the sample of the domain, which is shared with the context of "sol",
+ * is removed.
+ * If the thread cannot be started, then the solutions
+ * are computed by the current thread.
+ */
+static void sol_fork(struct isl_sol *sol, struct isl_tab *tab, isl_int *ineq)
+{
+	isl_ctx *ctx;
+	struct isl_sol_thread *thread;
+	unsigned len = 1 + tab->n_param + tab->n_div;
+
+	ctx = tab->mat->ctx;
+	thread = isl_calloc_type(ctx, struct isl_sol_thread);
+	if (!thread)
+		goto error;
+	thread->next = sol->threads;
+	sol->threads = thread;
+
+	thread->sol = sol->fork(sol);
+	thread->dom = sol_domain(sol);
+	if (thread->dom) {
+		isl_vec_free(thread->dom->sample);
+		thread->dom->sample = NULL;
+	}
+	thread->n_unknown = sol->context->n_unknown;
+	thread->ineq = isl_vec_alloc(ctx, len);
+	thread->tab = isl_tab_dup(tab);
+	if (!thread->sol || !thread->dom || !thread->ineq || !thread->tab)
+		goto error;
+	isl_seq_cpy(thread->ineq->el, ineq, len);
+
+#ifdef HAVE_PTHREAD
+	if (pthread_create(&thread->thread, NULL, &sol_thread_run, thread) == 0) {
+		thread->started = 1;
+		return;
+	}
+#endif
+	sol_thread_run(thread);
+	return;
+error:
+	sol->error = 1;
+}
+
+/* Wait for the threads started from "sol" to finish and
+ * remove them from "sol".
+ * If "join" is set and no error has occurred,
+ * then the solutions computed by these threads are added to "sol".
+ * The threads are handled in the order in which they were started.
+ */
+static void sol_wait_threads(struct isl_sol *sol, int join)
+{
+	struct isl_sol_thread *thread, *next, *started = NULL;
+
+	for (thread = sol->threads; thread; thread = next) {
+		next = thread->next;
+		thread->next = started;
+		started = thread;
+	}
+	sol->threads = NULL;
+
+	for (thread = started; thread; thread = next) {
+		next = thread->next;
+#ifdef HAVE_PTHREAD
+		if (thread->started)
+			pthread_join(thread->thread, NULL);
+#endif
+		if (!thread->sol || thread->sol->error)
+			sol->error = 1;
+		else if (join && !sol->error)
+			sol->join(sol, thread->sol);
+		sol_thread_free(thread);
+	}
+}
+
+/* Add the solutions computed by the threads started from "sol" to "sol".
+ */
+static void sol_join_threads(struct isl_sol *sol)
+{
+	sol_wait_threads(sol, 1);
+}
+
+/* Wait for the threads started from "sol" to finish,
+ * discarding their results.
+ */
+static void sol_free_threads(struct isl_sol *sol)
+{
+	sol_wait_threads(sol, 0);
+}
 
 /* Find solutions for values of the parameters that satisfy the given
  * inequality.
  *
- * We currently take a snapshot of the context tableau that is reset
- * when we return from this function, while we make a copy of the main
- * tableau, leaving the original main tableau untouched.
+ * If this part of the context should be solved in a separate thread,
+ * then hand it off to sol_fork.  The solutions are then only added
+ * to "sol" when the thread is joined.  Since they are not
+ * on the stack of partial solutions of "sol", they cannot be merged
+ * with those of the other part of the context.
+ *
+ * Otherwise, we currently take a snapshot of the context tableau
+ * that is reset when we return from this function, while we make a copy
+ * of the main tableau, leaving the original main tableau untouched.
  * These are fairly arbitrary choices.  Making a copy also of the context
  * tableau would obviate the need to undo any changes made to it later,
  * while taking a snapshot of the main tableau could reduce memory usage.
@@ -3708,6 +4005,10 @@ static void find_in_pos(struct isl_sol *sol, struct isl_tab *tab, isl_int *ineq)
 
 	if (!sol->context)
 		goto error;
+	if (sol_fork_split(sol, tab)) {
+		sol_fork(sol, tab, ineq);
+		return;
+	}
 	saved = sol->context->op->save(sol->context);
 
 	tab = isl_tab_dup(tab);
@@ -3813,6 +4114,8 @@ static void reset_any_to_unknown(struct isl_tab *tab)
  * The non-negative part is handled by a recursive call (through find_in_pos).
  * Upon returning from this call, we continue with the negative part and
  * perform the required pivot.
+ * Both parts are considered to be one level deeper in sol->depth,
+ * which is restored when returning from this function.
  *
  * If no such rows can be found, all rows are non-negative and we have
  * found a (rational) feasible point.  If we only wanted a rational point
@@ -3872,6 +4175,7 @@ static void find_solutions(struct isl_sol *sol, struct isl_tab *tab)
 {
 	struct isl_context *context;
 	int r;
+	int depth = sol->depth;
 
 	if (!tab || sol->error)
 		goto error;
@@ -3919,6 +4223,7 @@ static void find_solutions(struct isl_sol *sol, struct isl_tab *tab)
 			reset_any_to_unknown(tab);
 			tab->row_sign[split] = isl_tab_row_pos;
 			sol_inc_level(sol);
+			sol->depth++;
 			find_in_pos(sol, tab, ineq->el);
 			tab->row_sign[split] = isl_tab_row_neg;
 			isl_seq_neg(ineq->el, ineq->el, ineq->size);
@@ -3976,9 +4281,11 @@ static void find_solutions(struct isl_sol *sol, struct isl_tab *tab)
 done:
 	sol_add(sol, tab);
 	isl_tab_free(tab);
+	sol->depth = depth;
 	return;
 error:
 	isl_tab_free(tab);
+	sol->depth = depth;
 	sol->error = 1;
 }
 
@@ -4000,6 +4307,36 @@ static int sol_has_mergeable_solutions(struct isl_sol *sol)
 	return sol->partial->level == sol->partial->next->level;
 }
 
+/* Compute the lexicographic minimum of the set represented by the main
+ * tableau "tab" within the context "sol->context_tab",
+ * starting at the outer level.
+ *
+ * Before we embark on the actual computation, we save a copy
+ * of the context.  When we return, we check if there are any
+ * partial solutions that can potentially be merged.  If so,
+ * we perform a rollback to the initial state of the context.
+ * The merging of partial solutions happens inside calls to
+ * sol_dec_level that are pushed onto the undo stack of the context.
+ * If there are no partial solutions that can potentially be merged
+ * then the rollback is skipped as it would just be wasted effort.
+ */
+static void find_solutions_top(struct isl_sol *sol, struct isl_tab *tab)
+{
+	void *saved;
+
+	saved = sol->context->op->save(sol->context);
+
+	find_solutions(sol, tab);
+
+	if (sol_has_mergeable_solutions(sol))
+		sol->context->op->restore(sol->context, saved);
+	else
+		sol->context->op->discard(saved);
+
+	sol->level = 0;
+	sol_pop(sol);
+}
+
 /* Compute the lexicographic minimum of the set represented by the main
  * tableau "tab" within the context "sol->context_tab".
  *
@@ -4011,19 +4348,13 @@ static int sol_has_mergeable_solutions(struct isl_sol *sol)
  * In parts of the context where the added equality does not hold,
  * the main tableau is marked as being empty.
  *
- * Before we embark on the actual computation, we save a copy
- * of the context.  When we return, we check if there are any
- * partial solutions that can potentially be merged.  If so,
- * we perform a rollback to the initial state of the context.
- * The merging of partial solutions happens inside calls to
- * sol_dec_level that are pushed onto the undo stack of the context.
- * If there are no partial solutions that can potentially be merged
- * then the rollback is skipped as it would just be wasted effort.
+ * The actual computation is performed by find_solutions_top,
+ * after which the solutions computed by any threads
+ * that were started along the way are added to "sol".
  */
 static void find_solutions_main(struct isl_sol *sol, struct isl_tab *tab)
 {
 	int row;
-	void *saved;
 
 	if (!tab)
 		goto error;
@@ -4073,17 +4404,8 @@ static void find_solutions_main(struct isl_sol *sol, struct isl_tab *tab)
 		row = tab->n_redundant - 1;
 	}
 
-	saved = sol->context->op->save(sol->context);
-
-	find_solutions(sol, tab);
-
-	if (sol_has_mergeable_solutions(sol))
-		sol->context->op->restore(sol->context, saved);
-	else
-		sol->context->op->discard(saved);
-
-	sol->level = 0;
-	sol_pop(sol);
+	find_solutions_top(sol, tab);
+	sol_join_threads(sol);
 
 	return;
 error:
@@ -5481,6 +5803,58 @@ static void sol_pma_add_wrap(struct isl_sol *sol,
 	sol_pma_add((struct isl_sol_pma *)sol, dom, M);
 }
 
+/* Create an isl_sol_pma for collecting the solutions of a part
+ * of the context of "sol" in a separate thread.
+ */
+static struct isl_sol *sol_pma_fork(struct isl_sol *sol)
+{
+	struct isl_sol_pma *sol_pma = (struct isl_sol_pma *) sol;
+	struct isl_sol_pma *fork;
+
+	fork = isl_calloc_type(isl_pw_multi_aff_get_ctx(sol_pma->pma),
+				struct isl_sol_pma);
+	if (!fork)
+		return NULL;
+
+	sol_init_fork(&fork->sol, sol);
+	fork->pma = isl_pw_multi_aff_empty(
+				isl_pw_multi_aff_get_space(sol_pma->pma));
+	if (!fork->pma)
+		goto error;
+	if (sol_pma->empty) {
+		fork->empty = isl_set_alloc_space(
+			isl_set_get_space(sol_pma->empty), 1, ISL_SET_DISJOINT);
+		if (!fork->empty)
+			goto error;
+	}
+
+	return &fork->sol;
+error:
+	sol_pma_free(fork);
+	return NULL;
+}
+
+/* Add the solutions collected in "child" to those in "sol".
+ * Since "child" collects the solutions of a part of the context
+ * that is disjoint from the rest, the results are disjoint as well.
+ */
+static void sol_pma_join(struct isl_sol *sol, struct isl_sol *child)
+{
+	struct isl_sol_pma *sol_pma = (struct isl_sol_pma *) sol;
+	struct isl_sol_pma *child_pma = (struct isl_sol_pma *) child;
+
+	sol_pma->pma = isl_pw_multi_aff_add_disjoint(sol_pma->pma,
+					isl_pw_multi_aff_copy(child_pma->pma));
+	if (!sol_pma->pma)
+		sol->error = 1;
+	if (!sol_pma->empty)
+		return;
+	sol_pma->empty = isl_set_union_disjoint(sol_pma->empty,
+					isl_set_copy(child_pma->empty));
+	if (!sol_pma->empty)
+		sol->error = 1;
+}
+
 /* Construct an isl_sol_pma structure for accumulating the solution.
  * If track_empty is set, then we also keep track of the parts
  * of the context where there is no solution.
@@ -5508,6 +5882,8 @@ static struct isl_sol *sol_pma_init(__isl_keep isl_basic_map *bmap,
 	sol_pma->sol.add = &sol_pma_add_wrap;
 	sol_pma->sol.add_empty = track_empty ? &sol_pma_add_empty_wrap : NULL;
 	sol_pma->sol.free = &sol_pma_free_wrap;
+	sol_pma->sol.fork = &sol_pma_fork;
+	sol_pma->sol.join = &sol_pma_join;
 	sol_pma->pma = isl_pw_multi_aff_empty(isl_basic_map_get_space(bmap));
 	if (!sol_pma->pma)
 		goto error;
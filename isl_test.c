@@ -33,9 +33,15 @@
 #include <isl/schedule_node.h>
 #include <isl_options_private.h>
 #include <isl_vertices_private.h>
+#include <isl_lp_private.h>
+#include <isl_seq.h>
+#include <isl_vec_private.h>
 #include <isl/ast_build.h>
 #include <isl/val.h>
 #include <isl/ilp.h>
+#include <isl/lp.h>
+#include <isl/solver.h>
+#include <isl/map_pipeline.h>
 #include <isl_ast_build_expr.h>
 #include <isl/options.h>
 
@@ -1019,11 +1025,52 @@ void test_application_case(struct isl_ctx *ctx, const char *name)
 	fclose(input);
 }
 
+/* Inputs for isl_map_apply_range tests on maps with several disjuncts.
+ * "map1" and "map2" are composed and the result is expected
+ * to be equal to "res".
+ */
+struct {
+	const char *map1;
+	const char *map2;
+	const char *res;
+} apply_range_tests[] = {
+	{ "{ [i] -> [j] : 0 <= i <= 10 and 0 <= j <= 5 or "
+			"20 <= i <= 30 and 100 <= j <= 105 }",
+	  "{ [j] -> [k] : 0 <= j <= 10 and 0 <= k <= 3 or "
+			"100 <= j <= 110 and 7 <= k <= 9 or j >= 200 and k = 0 }",
+	  "{ [i] -> [k] : 0 <= i <= 10 and 0 <= k <= 3 or "
+			"20 <= i <= 30 and 7 <= k <= 9 }" },
+	{ "[n] -> { [i] -> [j] : n >= 10 and j = i or n <= 0 and j = -i }",
+	  "[n] -> { [j] -> [k] : n <= 0 and k = j + 1 or "
+			"1 <= n <= 5 and k = j }",
+	  "[n] -> { [i] -> [k] : n <= 0 and k = 1 - i }" },
+};
+
 static int test_application(isl_ctx *ctx)
 {
+	int i;
+
 	test_application_case(ctx, "application");
 	test_application_case(ctx, "application2");
 
+	for (i = 0; i < ARRAY_SIZE(apply_range_tests); ++i) {
+		isl_map *map1, *map2, *res;
+		isl_bool equal;
+
+		map1 = isl_map_read_from_str(ctx, apply_range_tests[i].map1);
+		map2 = isl_map_read_from_str(ctx, apply_range_tests[i].map2);
+		res = isl_map_read_from_str(ctx, apply_range_tests[i].res);
+		map1 = isl_map_apply_range(map1, map2);
+		equal = isl_map_is_equal(map1, res);
+		isl_map_free(map1);
+		isl_map_free(res);
+		if (equal < 0)
+			return -1;
+		if (!equal)
+			isl_die(ctx, isl_error_unknown,
+				"unexpected composition", return -1);
+	}
+
 	return 0;
 }
 
@@ -1870,6 +1917,11 @@ struct {
 	       "[x, y] : 0 <= x <= 10 and 1 <= y <= 10 }" },
 	{ 1, "{ [a] : a <= 8 and "
 			"(a mod 10 = 7 or a mod 10 = 8 or a mod 10 = 9) }" },
+	{ 0, "{ [x, y] : 0 <= x <= 2 and 0 <= y <= 5 or "
+		"4 <= x <= 6 and 0 <= y <= 5 }" },
+	{ 0, "{ [x] : 0 <= x <= 1 or 3 <= x <= 4 or x = 2 or 6 <= x <= 7 }" },
+	{ 1, "{ [x, y] : 0 <= x <= 2 and 0 <= y <= 5 or "
+		"3 <= x <= 6 and 0 <= y <= 5 }" },
 };
 
 /* A specialized coalescing test case that would result
@@ -1937,6 +1989,58 @@ static int test_coalesce_special2(struct isl_ctx *ctx)
 	return 0;
 }
 
+/* Coalesce the set described by "str".
+ */
+static __isl_give isl_set *coalesce_str(isl_ctx *ctx, const char *str)
+{
+	return isl_set_coalesce(isl_set_read_from_str(ctx, str));
+}
+
+/* Check that the coalesce cache returns the earlier result
+ * for an input that is equal to an earlier input, up to the order
+ * of the disjuncts, and that the least recently used result gets evicted.
+ */
+static int test_coalesce_cache(isl_ctx *ctx)
+{
+	int size;
+	int hit, evicted;
+	isl_bool equal;
+	isl_set *set1, *set2, *set3;
+	const char *str1 = "{ [x] : 0 <= x <= 10; [x] : 5 <= x <= 20 }";
+	const char *str2 = "{ [x] : 5 <= x <= 20; [x] : 0 <= x <= 10 }";
+	const char *str3 = "{ [x] : 0 <= x <= 1; [x] : 1 <= x <= 2 }";
+	const char *str4 = "{ [x] : 0 <= x <= 2; [x] : 2 <= x <= 3 }";
+
+	size = isl_options_get_coalesce_cache_size(ctx);
+	isl_options_set_coalesce_cache_size(ctx, 2);
+	set1 = coalesce_str(ctx, str1);
+	set2 = coalesce_str(ctx, str2);
+	hit = set1 && set1 == set2;
+	isl_set_free(set2);
+	isl_set_free(coalesce_str(ctx, str3));
+	isl_set_free(coalesce_str(ctx, str4));
+	set3 = coalesce_str(ctx, str1);
+	evicted = set3 && set1 != set3;
+	equal = isl_set_is_equal(set1, set3);
+	isl_set_free(set1);
+	isl_set_free(set3);
+	isl_options_set_coalesce_cache_size(ctx, size);
+
+	if (equal < 0)
+		return -1;
+	if (!hit)
+		isl_die(ctx, isl_error_unknown, "expecting cache hit",
+			return -1);
+	if (!evicted)
+		isl_die(ctx, isl_error_unknown, "expecting cache eviction",
+			return -1);
+	if (!equal)
+		isl_die(ctx, isl_error_unknown, "unexpected result",
+			return -1);
+
+	return 0;
+}
+
 /* Test the functionality of isl_set_coalesce.
  * That is, check that the output is always equal to the input
  * and in some cases that the result consists of a single disjunct.
@@ -1958,6 +2062,8 @@ static int test_coalesce(struct isl_ctx *ctx)
 		return -1;
 	if (test_coalesce_special2(ctx) < 0)
 		return -1;
+	if (test_coalesce_cache(ctx) < 0)
+		return -1;
 
 	return 0;
 }
@@ -2469,9 +2575,69 @@ struct {
 	{ "{ [a, b] : 0 <= a, b <= 100 and b mod 2 = 0}",
 	  "{ [a, b] -> [floor((b - 2*floor((-a)/4))/5)] }",
 	  &isl_set_max_val, "30" },
+	{ "{ [x, y] : x, y >= 0 and "
+		"3037000499 x + 3037000497 y <= 30370004981 and "
+		"3037000497 x + 3037000499 y <= 30370004981 }",
+	  "{ [x, y] -> [x + y] }", &isl_set_max_val, "10" },
+	{ "{ [x, y] : x, y >= 0 and "
+		"1099511627777 x + 1099511627775 y <= 2361183256827985395715 and "
+		"1099511627775 x + 1099511627777 y <= 2361183256827985395715 }",
+	  "{ [x, y] -> [x + y] }", &isl_set_max_val, "2147483662" },
 
 };
 
+/* Check that isl_set_max_val_bounded returns an upper bound on the maximum
+ * that is no weaker than the rational maximum when the search
+ * for the integer optimum is cut short and the exact maximum otherwise.
+ * Also check that isl_set_max_val is not affected by the step limit.
+ */
+static int test_min_bounded(isl_ctx *ctx)
+{
+	const char *str;
+	int exact1, exact2;
+	isl_basic_set *bset;
+	isl_set *set;
+	isl_aff *obj;
+	isl_val *bound, *max, *rat_max, *exact_max, *res;
+	isl_bool ok;
+
+	str = "{ [x, y, z] : 0 <= x, y, z and 13x + 17y + 19z <= 200 and "
+				"2x - 3y + z <= 7 and x - 2y >= -3 }";
+	bset = isl_basic_set_read_from_str(ctx, str);
+	set = isl_set_from_basic_set(isl_basic_set_copy(bset));
+	obj = isl_aff_read_from_str(ctx, "{ [x, y, z] -> [(3x + 4y + 5z)] }");
+	bound = isl_set_max_val_bounded(set, obj, 1, &exact1);
+	exact_max = isl_set_max_val_bounded(set, obj, 0, &exact2);
+	max = isl_set_max_val(set, obj);
+	rat_max = isl_basic_set_max_lp_val(bset, obj);
+	res = isl_val_int_from_si(ctx, 51);
+	ok = isl_val_eq(max, res);
+	if (ok == isl_bool_true)
+		ok = isl_val_eq(exact_max, max);
+	if (ok == isl_bool_true)
+		ok = isl_val_ge(bound, max);
+	if (ok == isl_bool_true)
+		ok = isl_val_le(bound, rat_max);
+	if (ok == isl_bool_true)
+		ok = !exact1 && exact2;
+	isl_val_free(res);
+	isl_val_free(rat_max);
+	isl_val_free(max);
+	isl_val_free(exact_max);
+	isl_val_free(bound);
+	isl_aff_free(obj);
+	isl_set_free(set);
+	isl_basic_set_free(bset);
+
+	if (ok < 0)
+		return -1;
+	if (!ok)
+		isl_die(ctx, isl_error_unknown,
+			"unexpected bounded optimum", return -1);
+
+	return 0;
+}
+
 /* Perform basic isl_set_min_val and isl_set_max_val tests.
  * In particular, check the results on non-convex inputs.
  */
@@ -2505,6 +2671,8 @@ static int test_min(struct isl_ctx *ctx)
 		return -1;
 	if (test_min_special2(ctx) < 0)
 		return -1;
+	if (test_min_bounded(ctx) < 0)
+		return -1;
 
 	return 0;
 }
@@ -3038,6 +3206,26 @@ static int test_union(isl_ctx *ctx)
 		isl_die(ctx, isl_error_unknown, "union sets not equal",
 			return -1);
 
+	str = "{ A[i] -> B[i] : 0 <= i <= 10; B[i] -> C[i] : i >= 0; "
+		"C[i] -> D[i] }";
+	umap1 = isl_union_map_read_from_str(ctx, str);
+	str = "{ B[i] -> C[o] : i >= 5 }";
+	umap2 = isl_union_map_read_from_str(ctx, str);
+	umap1 = isl_union_map_gist(umap1, umap2);
+	str = "{ B[i] -> C[i] }";
+	umap2 = isl_union_map_read_from_str(ctx, str);
+
+	equal = isl_union_map_is_equal(umap1, umap2);
+
+	isl_union_map_free(umap1);
+	isl_union_map_free(umap2);
+
+	if (equal < 0)
+		return -1;
+	if (!equal)
+		isl_die(ctx, isl_error_unknown, "union maps not equal",
+			return -1);
+
 	return 0;
 }
 
@@ -3178,6 +3366,87 @@ static int test_subset(isl_ctx *ctx)
 	return 0;
 }
 
+/* Inputs for isl_set_is_subset tests that check which test
+ * decided the result.
+ * "subset" is the expected result and "decision" is the test
+ * that is expected to decide it.
+ */
+struct {
+	const char *set1;
+	const char *set2;
+	int subset;
+	enum isl_subset_decision decision;
+} subset_decision_tests[] = {
+	{ "{ [i] : 0 <= i <= 10 }", "{ [i] }", 1, isl_subset_universe },
+	{ "{ [i] : exists a : i = 3a and 0 <= i <= 10 }",
+	  "{ [i] : exists a : i = 3a and 0 <= i <= 10 }",
+	  1, isl_subset_plain },
+	{ "{ [i, j] : 0 <= i <= 5 and 0 <= j <= i }",
+	  "{ [i, j] : 0 <= j <= i <= 10 }", 1, isl_subset_plain },
+	{ "{ [i] : 0 <= i <= 5 or 20 <= i <= 30 }",
+	  "{ [i] : 0 <= i <= 10 }", 0, isl_subset_bounds },
+	{ "{ [i, j] : 0 <= i, j <= 10 }",
+	  "{ [i, j] : i, j >= 0 and i + j <= 30 }", 1, isl_subset_exact },
+	{ "{ [i] : 0 <= i <= 10 }",
+	  "{ [i] : 0 <= i <= 5 or 7 <= i <= 12 }", 0, isl_subset_exact },
+};
+
+/* Return the number of subset queries that were decided
+ * by the test "decision" according to "stats".
+ */
+static long subset_decision_count(const struct isl_stats *stats,
+	enum isl_subset_decision decision)
+{
+	switch (decision) {
+	case isl_subset_universe:	return stats->subset_universe;
+	case isl_subset_plain:		return stats->subset_plain;
+	case isl_subset_bounds:		return stats->subset_bounds;
+	case isl_subset_exact:		return stats->subset_exact;
+	}
+
+	return -1;
+}
+
+/* Check that the subset queries in subset_decision_tests
+ * produce the expected results and that each of them is counted
+ * as having been decided by the expected test.
+ */
+static int test_subset_decisions(isl_ctx *ctx)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(subset_decision_tests); ++i) {
+		isl_set *set1, *set2;
+		const struct isl_stats *stats;
+		isl_bool subset;
+		long count;
+
+		set1 = isl_set_read_from_str(ctx,
+					subset_decision_tests[i].set1);
+		set2 = isl_set_read_from_str(ctx,
+					subset_decision_tests[i].set2);
+		isl_ctx_reset_stats(ctx);
+		subset = isl_set_is_subset(set1, set2);
+		isl_set_free(set1);
+		isl_set_free(set2);
+		if (subset < 0)
+			return -1;
+		if (subset != subset_decision_tests[i].subset)
+			isl_die(ctx, isl_error_unknown,
+				"incorrect subset result", return -1);
+		stats = isl_ctx_get_stats(ctx);
+		count = stats->subset_universe + stats->subset_plain +
+			stats->subset_bounds + stats->subset_exact;
+		if (count != 1 || subset_decision_count(stats,
+				    subset_decision_tests[i].decision) != 1)
+			isl_die(ctx, isl_error_unknown,
+				"subset query not decided by expected test",
+				return -1);
+	}
+
+	return 0;
+}
+
 struct {
 	const char *minuend;
 	const char *subtrahend;
@@ -3188,6 +3457,64 @@ struct {
 	{ "{ A[i] -> B[i] }", "{ A[i] : i > 0 }", "{ A[i] -> B[i] : i <= 0 }" },
 };
 
+/* Inputs for isl_set_subtract tests on sets with several disjuncts.
+ * "difference" is the expected difference of "minuend" and "subtrahend".
+ */
+struct {
+	const char *minuend;
+	const char *subtrahend;
+	const char *difference;
+} subtract_disjunct_tests[] = {
+	{ "{ [x, y] : 0 <= x, y <= 10 }",
+	  "{ [x, y] : 3 <= x <= 5 and 3 <= y <= 5 or x >= 20 or "
+		"y <= -5 or 4 <= x <= 8 and y = 9 }",
+	  "{ [x, y] : 0 <= x, y <= 10 and (x <= 2 or x >= 6 or "
+		"y <= 2 or y >= 6) and not (4 <= x <= 8 and y = 9) }" },
+	{ "{ [x] : 0 <= x <= 10 or 20 <= x <= 30 }",
+	  "{ [x] : x <= -1 or 5 <= x <= 25 or x >= 40 }",
+	  "{ [x] : 0 <= x <= 4 or 26 <= x <= 30 }" },
+};
+
+/* Check that isl_set_subtract produces the expected results
+ * on the inputs in subtract_disjunct_tests, both with and
+ * without coalescing the intermediate results.
+ */
+static int test_subtract_disjuncts(isl_ctx *ctx)
+{
+	int i, c;
+	int coalesce;
+	isl_bool equal = isl_bool_true;
+
+	coalesce = isl_options_get_subtract_coalesce(ctx);
+	for (c = 0; c < 2; ++c) {
+		isl_options_set_subtract_coalesce(ctx, c);
+		for (i = 0; equal == isl_bool_true &&
+			    i < ARRAY_SIZE(subtract_disjunct_tests); ++i) {
+			isl_set *set1, *set2, *diff;
+
+			set1 = isl_set_read_from_str(ctx,
+				subtract_disjunct_tests[i].minuend);
+			set2 = isl_set_read_from_str(ctx,
+				subtract_disjunct_tests[i].subtrahend);
+			diff = isl_set_read_from_str(ctx,
+				subtract_disjunct_tests[i].difference);
+			set1 = isl_set_subtract(set1, set2);
+			equal = isl_set_is_equal(set1, diff);
+			isl_set_free(set1);
+			isl_set_free(diff);
+		}
+	}
+	isl_options_set_subtract_coalesce(ctx, coalesce);
+
+	if (equal < 0)
+		return -1;
+	if (!equal)
+		isl_die(ctx, isl_error_unknown, "incorrect difference",
+			return -1);
+
+	return 0;
+}
+
 static int test_subtract(isl_ctx *ctx)
 {
 	int i;
@@ -3235,6 +3562,53 @@ static int test_subtract(isl_ctx *ctx)
 	return 0;
 }
 
+/* Check that intersecting sets with several disjuncts,
+ * some of which are obviously separated by their bounds,
+ * produces the expected result.
+ * Also check that composing a map with several disjuncts
+ * with an empty map, for which no bounds are computed,
+ * produces an empty map.
+ */
+static int test_intersect_disjuncts(isl_ctx *ctx)
+{
+	const char *str;
+	isl_set *set1, *set2, *res;
+	isl_map *map1, *map2;
+	isl_bool equal, empty;
+
+	str = "{ [x, y] : 0 <= x <= 5 and 0 <= y <= 5 or "
+		"10 <= x <= 15 and y = 3 or 20 <= x <= 25 and y >= 7 }";
+	set1 = isl_set_read_from_str(ctx, str);
+	str = "{ [x, y] : 4 <= x <= 12 and 3 <= y <= 8 or x >= 30 }";
+	set2 = isl_set_read_from_str(ctx, str);
+	str = "{ [x, y] : 4 <= x <= 5 and 3 <= y <= 5 or "
+		"10 <= x <= 12 and y = 3 }";
+	res = isl_set_read_from_str(ctx, str);
+	set1 = isl_set_intersect(set1, set2);
+	equal = isl_set_is_equal(set1, res);
+	isl_set_free(set1);
+	isl_set_free(res);
+	if (equal < 0)
+		return -1;
+	if (!equal)
+		isl_die(ctx, isl_error_unknown, "unexpected intersection",
+			return -1);
+
+	str = "{ [x] -> [y] : 0 <= y <= x <= 5 or 10 <= y <= x <= 15 }";
+	map1 = isl_map_read_from_str(ctx, str);
+	map2 = isl_map_empty(isl_map_get_space(map1));
+	map1 = isl_map_apply_range(map1, map2);
+	empty = isl_map_is_empty(map1);
+	isl_map_free(map1);
+	if (empty < 0)
+		return -1;
+	if (!empty)
+		isl_die(ctx, isl_error_unknown, "expecting empty composition",
+			return -1);
+
+	return 0;
+}
+
 /* Check that intersecting the empty basic set with another basic set
  * does not increase the number of constraints.  In particular,
  * the empty basic set should maintain its canonical representation.
@@ -4826,26 +5200,58 @@ int test_product(isl_ctx *ctx)
 	return 0;
 }
 
-/* Check that two sets are not considered disjoint just because
- * they have a different set of (named) parameters.
+/* Inputs for disjointness tests.
+ * "disjoint" is set if "set1" and "set2" are disjoint.
+ */
+struct {
+	int disjoint;
+	const char *set1;
+	const char *set2;
+} disjoint_tests[] = {
+	{ 0, "[n] -> { [[]->[]] }", "{ [[]->[]] }" },
+	{ 1, "{ [x] : 0 <= x <= 10 }",
+	     "{ [x] : x < 0 or x > 10 or 20 <= x <= 30 }" },
+	{ 0, "{ [x] : 0 <= x <= 10 }", "{ [x] : x < 0 or 5 <= x <= 7 }" },
+	{ 1, "{ [x] : exists (e : x = 2e) }", "{ [x] : x = 1 or x = 3 }" },
+	{ 0, "{ [x] : exists (e : x = 2e) }",
+	     "{ [x] : x = 1 or x = 3 or 7 <= x <= 8 }" },
+	{ 1, "{ [x, y] : 0 <= x, y <= 5 or 10 <= x, y <= 15 }",
+	     "{ [x, y] : x = 2y + 1 and y >= 6 or "
+			"exists (e : x = 3e + 1 and 6 <= x <= 9) }" },
+	{ 0, "{ [x, y] : 0 <= x, y <= 5 or 10 <= x, y <= 15 }",
+	     "{ [x, y] : x = y + 1 and y >= 6 or "
+			"exists (e : x = 3e + 1 and 6 <= x <= 9) }" },
+};
+
+/* Check that isl_set_is_disjoint produces the expected results
+ * on the inputs in disjoint_tests and that the intersection
+ * of the inputs is empty if and only if they are disjoint.
+ * The first test checks that two sets are not considered disjoint
+ * just because they have a different set of (named) parameters.
  */
 static int test_disjoint(isl_ctx *ctx)
 {
-	const char *str;
-	isl_set *set, *set2;
-	int disjoint;
+	int i;
 
-	str = "[n] -> { [[]->[]] }";
-	set = isl_set_read_from_str(ctx, str);
-	str = "{ [[]->[]] }";
-	set2 = isl_set_read_from_str(ctx, str);
-	disjoint = isl_set_is_disjoint(set, set2);
-	isl_set_free(set);
-	isl_set_free(set2);
-	if (disjoint < 0)
-		return -1;
-	if (disjoint)
-		isl_die(ctx, isl_error_unknown, "unexpected result", return -1);
+	for (i = 0; i < ARRAY_SIZE(disjoint_tests); ++i) {
+		isl_set *set1, *set2;
+		isl_bool disjoint, empty;
+
+		set1 = isl_set_read_from_str(ctx, disjoint_tests[i].set1);
+		set2 = isl_set_read_from_str(ctx, disjoint_tests[i].set2);
+		disjoint = isl_set_is_disjoint(set1, set2);
+		set1 = isl_set_intersect(set1, set2);
+		empty = isl_set_is_empty(set1);
+		isl_set_free(set1);
+		if (disjoint < 0 || empty < 0)
+			return -1;
+		if (disjoint != disjoint_tests[i].disjoint)
+			isl_die(ctx, isl_error_unknown, "unexpected result",
+				return -1);
+		if (empty != disjoint)
+			isl_die(ctx, isl_error_unknown,
+				"inconsistent intersection", return -1);
+	}
 
 	return 0;
 }
@@ -5303,6 +5709,27 @@ int test_eliminate(isl_ctx *ctx)
 	if (equal < 0)
 		return -1;
 
+	str = "{ rat: [i, j, k] : 0 <= i <= 10 and i <= j <= i + 5 and "
+				"j - 2 <= k <= 2j and k <= 3i + 1 }";
+	map = isl_map_read_from_str(ctx, str);
+	map = isl_map_eliminate(map, isl_dim_out, 1, 1);
+	equal = map_check_equal(map, "{ rat: [i, j, k] : 0 <= i <= 10 and "
+				"i - 2 <= k <= 2i + 10 and k <= 3i + 1 }");
+	isl_map_free(map);
+	if (equal < 0)
+		return -1;
+
+	str = "{ rat: [x, a, b, c, d] : 0 <= a, b, c, d <= 1 and "
+				"a + b - c + d <= x <= a - b + c + d + 1 and "
+				"x <= 2a + b + c + 2 }";
+	map = isl_map_read_from_str(ctx, str);
+	map = isl_map_eliminate(map, isl_dim_out, 1, 4);
+	equal = map_check_equal(map, "{ rat: [x, a, b, c, d] : "
+				"-1 <= x <= 4 }");
+	isl_map_free(map);
+	if (equal < 0)
+		return -1;
+
 	return 0;
 }
 
@@ -5616,6 +6043,7 @@ static int test_preimage_union_map(isl_ctx *ctx)
 	int i;
 	isl_union_map *umap1, *umap2;
 	isl_multi_aff *ma;
+	isl_union_pw_multi_aff *upma;
 	int equal;
 
 	for (i = 0; i < ARRAY_SIZE(preimage_domain_tests); ++i) {
@@ -5636,6 +6064,21 @@ static int test_preimage_union_map(isl_ctx *ctx)
 				return -1);
 	}
 
+	umap1 = isl_union_map_read_from_str(ctx,
+		"{ B[i] -> C[i]; D[i] -> E[i]; F[i] -> C[i] }");
+	upma = isl_union_pw_multi_aff_read_from_str(ctx,
+		"{ A[i] -> B[i + 1]; G[i] -> D[2i]; H[i] -> B[i] }");
+	umap2 = isl_union_map_read_from_str(ctx,
+		"{ A[i] -> C[i + 1]; G[i] -> E[2i]; H[i] -> C[i] }");
+	umap1 = isl_union_map_preimage_domain_union_pw_multi_aff(umap1, upma);
+	equal = isl_union_map_is_equal(umap1, umap2);
+	isl_union_map_free(umap1);
+	isl_union_map_free(umap2);
+	if (equal < 0)
+		return -1;
+	if (!equal)
+		isl_die(ctx, isl_error_unknown, "bad preimage", return -1);
+
 	return 0;
 }
 
@@ -6727,7 +7170,7 @@ static int test_tile(isl_ctx *ctx)
 }
 
 /* Check that the domain hash of a space is equal to the hash
- * of the domain of the space.
+ * of the domain of the space and similarly for the range.
  */
 static int test_domain_hash(isl_ctx *ctx)
 {
@@ -6749,6 +7192,20 @@ static int test_domain_hash(isl_ctx *ctx)
 		isl_die(ctx, isl_error_unknown,
 			"domain hash not equal to hash of domain", return -1);
 
+	map = isl_map_read_from_str(ctx, "[n] -> { D[] -> A[B[x] -> C[]] }");
+	space = isl_map_get_space(map);
+	isl_map_free(map);
+	hash1 = isl_space_get_range_hash(space);
+	space = isl_space_range(space);
+	hash2 = isl_space_get_hash(space);
+	isl_space_free(space);
+
+	if (!space)
+		return -1;
+	if (hash1 != hash2)
+		isl_die(ctx, isl_error_unknown,
+			"range hash not equal to hash of range", return -1);
+
 	return 0;
 }
 
@@ -6775,6 +7232,264 @@ static int test_universe(isl_ctx *ctx)
 	return 0;
 }
 
+/* Add the constraint "str" >= 0 (or "str" = 0 if "eq" is set)
+ * to "solver".
+ */
+static __isl_give isl_solver *solver_add(__isl_take isl_solver *solver,
+	const char *str, int eq)
+{
+	isl_aff *aff;
+	isl_constraint *c;
+
+	aff = isl_aff_read_from_str(isl_solver_get_ctx(solver), str);
+	if (eq)
+		c = isl_equality_from_aff(aff);
+	else
+		c = isl_inequality_from_aff(aff);
+	return isl_solver_add_constraint(solver, c);
+}
+
+/* Check that the emptiness of "solver" is as expected.
+ */
+static int check_solver_empty(__isl_keep isl_solver *solver,
+	int rational_empty, int empty)
+{
+	isl_bool is_empty;
+
+	is_empty = isl_solver_is_rational_empty(solver);
+	if (is_empty < 0)
+		return -1;
+	if (is_empty != rational_empty)
+		isl_die(isl_solver_get_ctx(solver), isl_error_unknown,
+			"unexpected rational emptiness", return -1);
+	is_empty = isl_solver_is_empty(solver);
+	if (is_empty < 0)
+		return -1;
+	if (is_empty != empty)
+		isl_die(isl_solver_get_ctx(solver), isl_error_unknown,
+			"unexpected emptiness", return -1);
+	return 0;
+}
+
+/* Check that the maximum of "obj" over "solver" is equal to "expected".
+ */
+static int check_solver_max(__isl_keep isl_solver *solver,
+	__isl_keep isl_aff *obj, const char *expected)
+{
+	isl_ctx *ctx = isl_solver_get_ctx(solver);
+	isl_val *v, *v_expected;
+	isl_bool ok;
+
+	v = isl_solver_max_val(solver, obj);
+	v_expected = isl_val_read_from_str(ctx, expected);
+	ok = isl_val_eq(v, v_expected);
+	isl_val_free(v);
+	isl_val_free(v_expected);
+	if (ok < 0)
+		return -1;
+	if (!ok)
+		isl_die(ctx, isl_error_unknown,
+			"unexpected maximum", return -1);
+	return 0;
+}
+
+/* Perform some incremental emptiness and optimization queries
+ * on a two-dimensional box.
+ */
+static int test_solver(isl_ctx *ctx)
+{
+	isl_basic_set *bset;
+	isl_solver *solver;
+	isl_aff *obj;
+	int r = 0;
+
+	bset = isl_basic_set_read_from_str(ctx,
+				"{ [x, y] : 0 <= x <= 10 and 0 <= y <= 10 }");
+	solver = isl_solver_from_basic_set(bset);
+	obj = isl_aff_read_from_str(ctx, "{ [x, y] -> [(x + y)] }");
+
+	if (check_solver_empty(solver, 0, 0) < 0 ||
+	    check_solver_max(solver, obj, "20") < 0)
+		r = -1;
+
+	solver = isl_solver_push(solver);
+	solver = solver_add(solver, "{ [x, y] -> [(2x - 2y - 1)] }", 1);
+	if (r == 0 && check_solver_empty(solver, 0, 1) < 0)
+		r = -1;
+	solver = isl_solver_push(solver);
+	solver = solver_add(solver, "{ [x, y] -> [(x - 11)] }", 0);
+	if (r == 0 && check_solver_empty(solver, 1, 1) < 0)
+		r = -1;
+	solver = isl_solver_pop(solver);
+	solver = isl_solver_pop(solver);
+
+	solver = isl_solver_push(solver);
+	solver = solver_add(solver, "{ [x, y] -> [(15 - 2x - 2y)] }", 0);
+	if (r == 0 && (check_solver_empty(solver, 0, 0) < 0 ||
+		       check_solver_max(solver, obj, "7") < 0))
+		r = -1;
+	solver = isl_solver_pop(solver);
+
+	solver = isl_solver_push(solver);
+	solver = solver_add(solver, "{ [x, y] -> [(x - y)] }", 1);
+	if (r == 0 && (check_solver_empty(solver, 0, 0) < 0 ||
+		       check_solver_max(solver, obj, "20") < 0))
+		r = -1;
+	solver = isl_solver_pop(solver);
+
+	if (r == 0 && (check_solver_empty(solver, 0, 0) < 0 ||
+		       check_solver_max(solver, obj, "20") < 0))
+		r = -1;
+
+	isl_aff_free(obj);
+	if (!solver)
+		r = -1;
+	isl_solver_free(solver);
+
+	return r;
+}
+
+/* Perform some basic operations on a context in thread-safe mode and
+ * check that identifiers are still shared and
+ * that errors are still reported.
+ * Also check that an error recorded in another context
+ * in thread-safe mode does not affect the error state of "ctx".
+ */
+static int test_thread_safe(isl_ctx *ctx)
+{
+	int on_error;
+	isl_ctx *ctx2;
+	isl_id *id1, *id2;
+	isl_set *set1, *set2;
+	isl_bool equal;
+	enum isl_error error;
+
+	if (isl_ctx_set_thread_safe(ctx, 1) < 0)
+		return -1;
+
+	id1 = isl_id_alloc(ctx, "A", NULL);
+	id2 = isl_id_alloc(ctx, "A", NULL);
+	equal = id1 && id1 == id2;
+	isl_id_free(id1);
+	isl_id_free(id2);
+
+	set1 = isl_set_read_from_str(ctx, "{ A[i] : 0 <= i <= 10 }");
+	set2 = isl_set_read_from_str(ctx, "{ A[i] : 5 <= i <= 20 }");
+	set1 = isl_set_coalesce(isl_set_union(set1, set2));
+	set2 = isl_set_read_from_str(ctx, "{ A[i] : 0 <= i <= 20 }");
+	if (equal)
+		equal = isl_set_is_equal(set1, set2);
+	isl_set_free(set1);
+	isl_set_free(set2);
+
+	on_error = isl_options_get_on_error(ctx);
+	isl_options_set_on_error(ctx, ISL_ON_ERROR_CONTINUE);
+	isl_ctx_reset_error(ctx);
+	set1 = isl_set_read_from_str(ctx, "{ A[i] }");
+	set2 = isl_set_read_from_str(ctx, "{ A[i, j] }");
+	set1 = isl_set_intersect(set1, set2);
+	isl_set_free(set1);
+	ctx2 = isl_ctx_alloc();
+	if (ctx2 && isl_ctx_set_thread_safe(ctx2, 1) >= 0)
+		isl_ctx_set_error(ctx2, isl_error_invalid);
+	isl_ctx_free(ctx2);
+	error = isl_ctx_last_error(ctx);
+	isl_ctx_reset_error(ctx);
+	isl_options_set_on_error(ctx, on_error);
+
+	if (isl_ctx_set_thread_safe(ctx, 0) < 0)
+		return -1;
+
+	if (equal < 0)
+		return -1;
+	if (!equal)
+		isl_die(ctx, isl_error_unknown,
+			"unexpected result in thread-safe mode", return -1);
+	if (error == isl_error_none)
+		isl_die(ctx, isl_error_unknown,
+			"error not reported in thread-safe mode", return -1);
+
+	return 0;
+}
+
+/* Maps for which the lexicographic optimum is computed
+ * with and without solving parts of context splits in separate threads.
+ */
+static const char *pip_parallel_tests[] = {
+	"[n, m] -> { [x, y] : 0 <= x <= n and 0 <= y <= m and "
+		"x + y >= 10 and x - y <= 3 }",
+	"[N] -> { [i] -> [j] : j >= 0 and j >= i - N and j >= N - i and "
+		"2j >= i }",
+	"{ [i, j] -> [a, b, c] : a >= i and a >= j and b >= a - 5 and "
+		"b >= 2i - j and c >= 0 and c >= b - i and c >= a + b - 10 }",
+	"[n] -> { [i, j] -> [k, l] : 0 <= k <= n and 0 <= l <= n and "
+		"k + l >= i and k - l >= j and 3l <= n + i + j }",
+	"[a, b, c] -> { [x] -> [y, z] : y >= x - a and y >= b - x and "
+		"y >= 0 and z >= y - c and z >= c - y and 2z >= x + y }",
+};
+
+/* Compute the lexicographic minimum of "map"
+ * as an isl_map and as an isl_pw_multi_aff and
+ * store the results in "res".
+ */
+static void pip_parallel_compute(__isl_keep isl_map *map, isl_map *res[2])
+{
+	isl_pw_multi_aff *pma;
+
+	res[0] = isl_map_lexmin(isl_map_copy(map));
+	pma = isl_map_lexmin_pw_multi_aff(isl_map_copy(map));
+	res[1] = isl_map_from_pw_multi_aff(pma);
+}
+
+/* Check that computing the lexicographic optimum of the elements
+ * of pip_parallel_tests while solving parts of context splits
+ * in separate threads produces the same results as computing them
+ * in a single thread.
+ */
+static int test_pip_parallel(isl_ctx *ctx)
+{
+	int i, j;
+	int depth;
+	int r = 0;
+
+	if (isl_ctx_set_thread_safe(ctx, 1) < 0)
+		return -1;
+	depth = isl_options_get_pip_parallel_depth(ctx);
+
+	for (i = 0; r == 0 && i < ARRAY_SIZE(pip_parallel_tests); ++i) {
+		isl_map *map;
+		isl_map *seq[2], *par[2];
+		isl_bool equal = isl_bool_true;
+
+		map = isl_map_read_from_str(ctx, pip_parallel_tests[i]);
+		isl_options_set_pip_parallel_depth(ctx, 0);
+		pip_parallel_compute(map, seq);
+		isl_options_set_pip_parallel_depth(ctx, 3);
+		pip_parallel_compute(map, par);
+		isl_map_free(map);
+
+		for (j = 0; j < 2; ++j) {
+			if (equal == isl_bool_true)
+				equal = isl_map_is_equal(seq[j], par[j]);
+			isl_map_free(seq[j]);
+			isl_map_free(par[j]);
+		}
+
+		if (equal < 0)
+			r = -1;
+		else if (!equal)
+			isl_die(ctx, isl_error_unknown,
+				"parallel lexicographic optimum differs",
+				r = -1);
+	}
+
+	isl_options_set_pip_parallel_depth(ctx, depth);
+	if (isl_ctx_set_thread_safe(ctx, 0) < 0)
+		return -1;
+
+	return r;
+}
+
 /* Sets for which chambers are computed and checked.
  */
 const char *chambers_tests[] = {
@@ -6863,10 +7578,379 @@ static int test_chambers(isl_ctx *ctx)
 	return 0;
 }
 
+/* Inputs for the pivot rule tests.
+ * "set" is a set, "obj" is an affine expression and
+ * "max" is the maximal value of "obj" over "set".
+ */
+struct {
+	const char *set;
+	const char *obj;
+	const char *max;
+} pivot_rule_tests[] = {
+	{ "{ [x, y] : 0 <= x <= 10 and 0 <= y <= 10 and x + y <= 15 }",
+	  "{ [x, y] -> [(2x + 3y)] }", "40" },
+	{ "{ [x, y, z] : x >= 0 and y >= 0 and z >= 0 and "
+			"x + y + z <= 6 and x - y <= 2 and 2y + z <= 7 }",
+	  "{ [x, y, z] -> [(3x + 2y - z)] }", "16" },
+	{ "{ [x, y] : 0 <= x and 0 <= y and 2x + 2y <= 9 }",
+	  "{ [x, y] -> [(x + y)] }", "4" },
+	{ "{ [x, y] : x >= 0 and y >= 0 and x - y <= 0 and x + y >= 1 }",
+	  "{ [x, y] -> [(x - y)] }", "0" },
+};
+
+/* Check that the maximal values in pivot_rule_tests are computed
+ * correctly with each of the pivot rules and that the pivots
+ * are recorded in the statistics of "ctx".
+ */
+static int test_pivot_rule(isl_ctx *ctx)
+{
+	int i, j;
+	int rule;
+	int rules[] = { ISL_PIVOT_BLAND, ISL_PIVOT_STEEPEST_EDGE,
+			ISL_PIVOT_DEVEX };
+
+	rule = isl_options_get_pivot_rule(ctx);
+	for (i = 0; i < ARRAY_SIZE(rules); ++i) {
+		isl_options_set_pivot_rule(ctx, rules[i]);
+		isl_ctx_reset_stats(ctx);
+		for (j = 0; j < ARRAY_SIZE(pivot_rule_tests); ++j) {
+			isl_set *set;
+			isl_aff *obj;
+			isl_val *max, *expected;
+			isl_bool equal;
+
+			set = isl_set_read_from_str(ctx,
+						pivot_rule_tests[j].set);
+			obj = isl_aff_read_from_str(ctx,
+						pivot_rule_tests[j].obj);
+			max = isl_set_max_val(set, obj);
+			expected = isl_val_read_from_str(ctx,
+						pivot_rule_tests[j].max);
+			equal = isl_val_eq(max, expected);
+			isl_val_free(max);
+			isl_val_free(expected);
+			isl_aff_free(obj);
+			isl_set_free(set);
+			if (equal < 0)
+				goto error;
+			if (!equal)
+				isl_die(ctx, isl_error_unknown,
+					"unexpected maximum", goto error);
+		}
+		if (isl_ctx_get_stats(ctx)->pivots <= 0)
+			isl_die(ctx, isl_error_unknown,
+				"no pivots recorded", goto error);
+	}
+	isl_options_set_pivot_rule(ctx, rule);
+
+	return 0;
+error:
+	isl_options_set_pivot_rule(ctx, rule);
+	return -1;
+}
+
+/* Compute the rational maximum of the objective of the pivot_rule_tests
+ * element at position "pos" over its set with the lp_double_start option
+ * set to "double_start".
+ */
+static __isl_give isl_val *lp_max(isl_ctx *ctx, int pos, int double_start)
+{
+	isl_basic_set *bset;
+	isl_aff *obj;
+	isl_val *max;
+
+	isl_options_set_lp_double_start(ctx, double_start);
+	bset = isl_basic_set_read_from_str(ctx, pivot_rule_tests[pos].set);
+	obj = isl_aff_read_from_str(ctx, pivot_rule_tests[pos].obj);
+	max = isl_basic_set_max_lp_val(bset, obj);
+	isl_aff_free(obj);
+	isl_basic_set_free(bset);
+
+	return max;
+}
+
+/* Check that starting the computation of a rational optimum
+ * from a basis computed in double precision does not affect the result
+ * and that the tableau is effectively moved to such a basis
+ * for at least some of the inputs.
+ */
+static int test_lp_double_start(isl_ctx *ctx)
+{
+	int i;
+	int double_start;
+
+	double_start = isl_options_get_lp_double_start(ctx);
+	isl_ctx_reset_stats(ctx);
+	for (i = 0; i < ARRAY_SIZE(pivot_rule_tests); ++i) {
+		isl_val *exact, *hybrid;
+		isl_bool equal;
+
+		exact = lp_max(ctx, i, 0);
+		hybrid = lp_max(ctx, i, 1);
+		equal = isl_val_eq(exact, hybrid);
+		isl_val_free(exact);
+		isl_val_free(hybrid);
+		if (equal < 0)
+			goto error;
+		if (!equal)
+			isl_die(ctx, isl_error_unknown,
+				"double precision start affects optimum",
+				goto error);
+	}
+	if (isl_ctx_get_stats(ctx)->lp_double_starts <= 0)
+		isl_die(ctx, isl_error_unknown,
+			"no double precision basis used", goto error);
+	isl_options_set_lp_double_start(ctx, double_start);
+
+	return 0;
+error:
+	isl_options_set_lp_double_start(ctx, double_start);
+	return -1;
+}
+
+/* Inputs for the LP presolve tests.
+ * "set" is a basic set and "obj" is an affine expression
+ * that is maximized over "set".
+ * The sets contain variables that can be removed by the presolve step,
+ * possibly only after other variables have been removed.
+ */
+struct {
+	const char *set;
+	const char *obj;
+} lp_presolve_tests[] = {
+	{ "{ [x, y, z] : x >= 0 and y >= 0 and x + y <= 4 and "
+		"z >= x - 2 and z >= y - 3 and z + x >= 1 }",
+	  "{ [x, y, z] -> [(x + 2y)] }" },
+	{ "{ [x, y, z, w] : 0 <= x <= 3 and 0 <= y <= 3 and 2x + y <= 7 and "
+		"z >= x + y - 4 and w >= z + x and 2w >= 3 - y }",
+	  "{ [x, y, z, w] -> [(2x + 3y)] }" },
+	{ "{ [x, y, z] : 2x + 3y <= 7 and 2x + 3y <= 8 and x >= 0 and "
+		"y >= 0 and x - y <= 1 and x - y >= 1 and 3z <= x - y }",
+	  "{ [x, y, z] -> [(x + y)] }" },
+};
+
+/* Check that "sol", with the denominator in its first element,
+ * satisfies the constraints of "bset" and that the value of "f"
+ * at "sol" is equal to "opt"/"opt_denom".
+ */
+static isl_stat check_lp_solution(__isl_keep isl_basic_set *bset,
+	isl_int *f, isl_int opt, isl_int opt_denom, __isl_keep isl_vec *sol)
+{
+	int i;
+	isl_ctx *ctx = isl_basic_set_get_ctx(bset);
+	unsigned total = isl_basic_set_total_dim(bset);
+	isl_int v, t;
+	isl_stat r = isl_stat_ok;
+
+	if (!sol)
+		return isl_stat_error;
+
+	isl_int_init(v);
+	isl_int_init(t);
+	for (i = 0; i < bset->n_eq; ++i) {
+		isl_seq_inner_product(bset->eq[i], sol->el, 1 + total, &v);
+		if (!isl_int_is_zero(v))
+			r = isl_stat_error;
+	}
+	for (i = 0; i < bset->n_ineq; ++i) {
+		isl_seq_inner_product(bset->ineq[i], sol->el, 1 + total, &v);
+		if (isl_int_is_neg(v))
+			r = isl_stat_error;
+	}
+	isl_seq_inner_product(f, sol->el, 1 + total, &v);
+	isl_int_mul(v, v, opt_denom);
+	isl_int_mul(t, opt, sol->el[0]);
+	if (isl_int_ne(v, t))
+		r = isl_stat_error;
+	isl_int_clear(t);
+	isl_int_clear(v);
+
+	if (r < 0)
+		isl_die(ctx, isl_error_unknown, "invalid LP solution",
+			return isl_stat_error);
+	return isl_stat_ok;
+}
+
+/* Compute the rational maximum of the objective of the lp_presolve_tests
+ * element at position "pos" over its set, with the lp_presolve option
+ * set to "presolve", and check the solution.
+ * Store the maximum in *opt / *opt_denom.
+ */
+static isl_stat lp_presolve_max(isl_ctx *ctx, int pos, int presolve,
+	isl_int *opt, isl_int *opt_denom)
+{
+	isl_basic_set *bset;
+	isl_aff *obj;
+	isl_vec *sol = NULL;
+	enum isl_lp_result res;
+	isl_stat r;
+
+	isl_options_set_lp_presolve(ctx, presolve);
+	bset = isl_basic_set_read_from_str(ctx, lp_presolve_tests[pos].set);
+	obj = isl_aff_read_from_str(ctx, lp_presolve_tests[pos].obj);
+	if (!bset || !obj)
+		r = isl_stat_error;
+	else
+		r = isl_stat_ok;
+	if (r >= 0) {
+		res = isl_basic_set_solve_lp(bset, 1, obj->v->el + 1, ctx->one,
+						opt, opt_denom, &sol);
+		if (res != isl_lp_ok)
+			r = isl_stat_error;
+	}
+	if (r >= 0)
+		r = check_lp_solution(bset, obj->v->el + 1, *opt, *opt_denom,
+					sol);
+	isl_vec_free(sol);
+	isl_aff_free(obj);
+	isl_basic_set_free(bset);
+
+	return r;
+}
+
+/* Check that simplifying rational LPs before solving them
+ * does not affect the optimum and that the optimal points
+ * are mapped back correctly.
+ */
+static int test_lp_presolve(isl_ctx *ctx)
+{
+	int i;
+	int presolve;
+	isl_int opt1, opt_denom1, opt2, opt_denom2;
+	isl_stat r = isl_stat_ok;
+
+	presolve = isl_options_get_lp_presolve(ctx);
+	isl_int_init(opt1);
+	isl_int_init(opt_denom1);
+	isl_int_init(opt2);
+	isl_int_init(opt_denom2);
+	for (i = 0; r >= 0 && i < ARRAY_SIZE(lp_presolve_tests); ++i) {
+		r = lp_presolve_max(ctx, i, 0, &opt1, &opt_denom1);
+		if (r >= 0)
+			r = lp_presolve_max(ctx, i, 1, &opt2, &opt_denom2);
+		if (r < 0)
+			break;
+		isl_int_mul(opt1, opt1, opt_denom2);
+		isl_int_mul(opt2, opt2, opt_denom1);
+		if (isl_int_ne(opt1, opt2))
+			isl_die(ctx, isl_error_unknown,
+				"presolve affects optimum", r = isl_stat_error);
+	}
+	isl_int_clear(opt_denom2);
+	isl_int_clear(opt2);
+	isl_int_clear(opt_denom1);
+	isl_int_clear(opt1);
+	isl_options_set_lp_presolve(ctx, presolve);
+
+	return r < 0 ? -1 : 0;
+}
+
+/* Inputs for isl_map_pipeline tests.
+ * The pipeline applies "range" to "map", intersects the domain
+ * of the result with "domain", projects out the first "n_in"
+ * input dimensions and the first "n_out" output dimensions and
+ * finally coalesces the result.
+ * If "param" is set, then the first parameter is also projected out.
+ */
+struct {
+	const char *map;
+	const char *range;
+	const char *domain;
+	int n_in;
+	int n_out;
+	int param;
+} pipeline_tests[] = {
+	{ "{ A[i, j] -> B[i + j, i - j] }",
+	  "{ B[x, y] -> C[x, y, x + y] : x >= 0 }",
+	  "{ A[i, j] : 0 <= i, j <= 10 }", 0, 2, 0 },
+	{ "{ A[i, j] -> B[i, i + j] : i <= 2j or i >= 3j + 5 }",
+	  "{ B[x, y] -> C[2x, y] }",
+	  "{ A[i, j] : 0 <= i <= j }", 1, 1, 0 },
+	{ "[n] -> { A[i] -> B[i, j] : 0 <= j < n }",
+	  "[n, m] -> { B[x, y] -> C[x + y] : y < m }",
+	  "[n] -> { A[i] : 0 <= i < n }", 0, 0, 1 },
+};
+
+/* Check that the isl_map_pipeline inputs in pipeline_tests
+ * produce the same result as performing the operations directly.
+ * Also check that a copy of the pipeline taken after the application
+ * of "range" is not affected by the subsequent operations.
+ */
+static int test_pipeline(isl_ctx *ctx)
+{
+	int i;
+	isl_bool equal = isl_bool_true;
+
+	for (i = 0; equal == isl_bool_true && i < ARRAY_SIZE(pipeline_tests);
+	    ++i) {
+		isl_map *map, *range, *applied, *res1, *res2, *res3;
+		isl_set *dom;
+		isl_map_pipeline *pipeline, *shared;
+
+		map = isl_map_read_from_str(ctx, pipeline_tests[i].map);
+		range = isl_map_read_from_str(ctx, pipeline_tests[i].range);
+		dom = isl_set_read_from_str(ctx, pipeline_tests[i].domain);
+
+		applied = isl_map_apply_range(isl_map_copy(map),
+					    isl_map_copy(range));
+		res1 = isl_map_intersect_domain(isl_map_copy(applied),
+					    isl_set_copy(dom));
+		res1 = isl_map_project_out(res1, isl_dim_in,
+					    0, pipeline_tests[i].n_in);
+		res1 = isl_map_project_out(res1, isl_dim_out,
+					    0, pipeline_tests[i].n_out);
+		if (pipeline_tests[i].param)
+			res1 = isl_map_project_out(res1, isl_dim_param, 0, 1);
+		res1 = isl_map_coalesce(res1);
+
+		pipeline = isl_map_pipeline_from_map(map);
+		pipeline = isl_map_pipeline_apply_range(pipeline, range);
+		shared = isl_map_pipeline_copy(pipeline);
+		pipeline = isl_map_pipeline_intersect_domain(pipeline, dom);
+		pipeline = isl_map_pipeline_project_out(pipeline, isl_dim_in,
+					    0, pipeline_tests[i].n_in);
+		pipeline = isl_map_pipeline_project_out(pipeline, isl_dim_out,
+					    0, pipeline_tests[i].n_out);
+		if (pipeline_tests[i].param)
+			pipeline = isl_map_pipeline_project_out(pipeline,
+							isl_dim_param, 0, 1);
+		pipeline = isl_map_pipeline_coalesce(pipeline);
+		res2 = isl_map_pipeline_evaluate(pipeline);
+		res3 = isl_map_pipeline_evaluate(shared);
+
+		equal = isl_map_is_equal(res1, res2);
+		if (equal == isl_bool_true)
+			equal = isl_map_is_equal(applied, res3);
+		isl_map_free(applied);
+		isl_map_free(res1);
+		isl_map_free(res2);
+		isl_map_free(res3);
+	}
+
+	if (equal < 0)
+		return -1;
+	if (!equal)
+		isl_die(ctx, isl_error_unknown,
+			"pipeline result differs from direct computation",
+			return -1);
+
+	return 0;
+}
+
 struct {
 	const char *name;
 	int (*fn)(isl_ctx *ctx);
 } tests [] = {
+	{ "map pipelines", &test_pipeline },
+	{ "subset decisions", &test_subset_decisions },
+	{ "subtraction of disjuncts", &test_subtract_disjuncts },
+	{ "intersection of disjuncts", &test_intersect_disjuncts },
+	{ "LP presolve", &test_lp_presolve },
+	{ "double precision LP start", &test_lp_double_start },
+	{ "pivot rules", &test_pivot_rule },
+	{ "incremental solver", &test_solver },
+	{ "thread-safe mode", &test_thread_safe },
+	{ "parallel lexicographic optimization", &test_pip_parallel },
 	{ "universe", &test_universe },
 	{ "domain hash", &test_domain_hash },
 	{ "dual", &test_dual },
@@ -11,6 +11,7 @@
 #include <assert.h>
 #include <stdio.h>
 #include <isl_int.h>
+#include <isl_seq.h>
 
 #define ARRAY_SIZE(array) (sizeof(array)/sizeof(*array))
 
@@ -598,11 +599,307 @@ struct {
 	{ &int_test_abs_cmp, "-1", "5", "-9223372036854775809" },
 };
 
+#ifdef USE_SMALL_INT_OPT
+/* Store the "len" elements of "p" in big representation if "big" is set
+ * and in small representation, where possible, otherwise.
+ */
+static void seq_set_representation(isl_int *p, unsigned len, int big)
+{
+	int i;
+
+	for (i = 0; i < len; ++i) {
+		if (big)
+			isl_sioimath_promote(p[i]);
+		else
+			isl_sioimath_try_demote(p[i]);
+	}
+}
+#else  /* USE_SMALL_INT_OPT */
+static void seq_set_representation(isl_int *p, unsigned len, int big)
+{
+}
+#endif /* USE_SMALL_INT_OPT */
+
+#define SEQ_LEN	4
+
+/* Read the SEQ_LEN elements of "str" into "p", using big representation
+ * if "big" is set.
+ */
+static void seq_read(isl_int *p, char *str[SEQ_LEN], int big)
+{
+	int i;
+
+	for (i = 0; i < SEQ_LEN; ++i)
+		isl_int_read(p[i], str[i]);
+	seq_set_representation(p, SEQ_LEN, big);
+}
+
+/* Check that the SEQ_LEN elements of "p" are equal to those of "str".
+ */
+static void seq_check(isl_int *p, char *str[SEQ_LEN])
+{
+	int i;
+	isl_int v;
+
+	isl_int_init(v);
+	for (i = 0; i < SEQ_LEN; ++i) {
+		isl_int_read(v, str[i]);
+		assert(isl_int_eq(p[i], v));
+	}
+	isl_int_clear(v);
+}
+
+static void seq_init(isl_int *p)
+{
+	int i;
+
+	for (i = 0; i < SEQ_LEN; ++i)
+		isl_int_init(p[i]);
+}
+
+static void seq_clear(isl_int *p)
+{
+	int i;
+
+	for (i = 0; i < SEQ_LEN; ++i)
+		isl_int_clear(p[i]);
+}
+
+/* Inputs for isl_seq_combine tests.
+ * "res" is equal to "m1" times "src1" plus "m2" times "src2".
+ */
+struct {
+	char *m1;
+	char *src1[SEQ_LEN];
+	char *m2;
+	char *src2[SEQ_LEN];
+	char *res[SEQ_LEN];
+} seq_combine_tests[] = {
+	{ "2", { "1", "-2", "3", "0" }, "-3", { "4", "5", "-6", "7" },
+	  { "-10", "-19", "24", "-21" } },
+	{ "2147483647", { "2147483647", "-2147483647", "1", "0" },
+	  "1", { "1", "1", "1", "1" },
+	  { "4611686014132420610", "-4611686014132420608",
+	    "2147483648", "1" } },
+	{ "-1", { "9223372036854775808", "0", "1", "2" },
+	  "2", { "1", "2", "3", "4" },
+	  { "-9223372036854775806", "4", "5", "6" } },
+};
+
+/* Check isl_seq_combine on the inputs in seq_combine_tests,
+ * both with a separate destination and in place,
+ * for all combinations of small and big representations of the inputs.
+ */
+static void seq_test_combine(void)
+{
+	int i, j;
+	isl_int m1, m2;
+	isl_int src1[SEQ_LEN], src2[SEQ_LEN], dst[SEQ_LEN];
+
+	isl_int_init(m1);
+	isl_int_init(m2);
+	seq_init(src1);
+	seq_init(src2);
+	seq_init(dst);
+
+	for (i = 0; i < ARRAY_SIZE(seq_combine_tests); ++i) {
+		isl_int_read(m1, seq_combine_tests[i].m1);
+		isl_int_read(m2, seq_combine_tests[i].m2);
+		for (j = 0; j < 4; ++j) {
+			seq_read(src1, seq_combine_tests[i].src1, j & 1);
+			seq_read(src2, seq_combine_tests[i].src2, j & 2);
+			isl_seq_combine(dst, m1, src1, m2, src2, SEQ_LEN);
+			seq_check(dst, seq_combine_tests[i].res);
+			isl_seq_combine(src1, m1, src1, m2, src2, SEQ_LEN);
+			seq_check(src1, seq_combine_tests[i].res);
+		}
+	}
+
+	isl_int_clear(m1);
+	isl_int_clear(m2);
+	seq_clear(src1);
+	seq_clear(src2);
+	seq_clear(dst);
+}
+
+/* Inputs for isl_seq_addmul and isl_seq_submul tests.
+ * "add" is equal to "dst" plus "f" times "src" and
+ * "sub" is equal to "dst" minus "f" times "src".
+ */
+struct {
+	char *f;
+	char *dst[SEQ_LEN];
+	char *src[SEQ_LEN];
+	char *add[SEQ_LEN];
+	char *sub[SEQ_LEN];
+} seq_addmul_tests[] = {
+	{ "3", { "1", "2", "3", "4" }, { "1", "-1", "0", "2" },
+	  { "4", "-1", "3", "10" }, { "-2", "5", "3", "-2" } },
+	{ "-2147483647", { "2147483647", "0", "-5", "1" },
+	  { "2147483647", "1", "0", "-2147483647" },
+	  { "-4611686011984936962", "-2147483647", "-5",
+	    "4611686014132420610" },
+	  { "4611686016279904256", "2147483647", "-5",
+	    "-4611686014132420608" } },
+	{ "2", { "18446744073709551616", "0", "0", "0" },
+	  { "1", "1", "1", "1" },
+	  { "18446744073709551618", "2", "2", "2" },
+	  { "18446744073709551614", "-2", "-2", "-2" } },
+};
+
+/* Check isl_seq_addmul and isl_seq_submul on the inputs
+ * in seq_addmul_tests for all combinations of small and big
+ * representations of the inputs.
+ */
+static void seq_test_addmul(void)
+{
+	int i, j;
+	isl_int f;
+	isl_int src[SEQ_LEN], dst[SEQ_LEN];
+
+	isl_int_init(f);
+	seq_init(src);
+	seq_init(dst);
+
+	for (i = 0; i < ARRAY_SIZE(seq_addmul_tests); ++i) {
+		isl_int_read(f, seq_addmul_tests[i].f);
+		for (j = 0; j < 4; ++j) {
+			seq_read(src, seq_addmul_tests[i].src, j & 2);
+			seq_read(dst, seq_addmul_tests[i].dst, j & 1);
+			isl_seq_addmul(dst, f, src, SEQ_LEN);
+			seq_check(dst, seq_addmul_tests[i].add);
+			seq_read(dst, seq_addmul_tests[i].dst, j & 1);
+			isl_seq_submul(dst, f, src, SEQ_LEN);
+			seq_check(dst, seq_addmul_tests[i].sub);
+		}
+	}
+
+	isl_int_clear(f);
+	seq_clear(src);
+	seq_clear(dst);
+}
+
+/* Inputs for isl_seq_gcd and isl_seq_normalize tests.
+ * "gcd" is the gcd of the elements of "seq" and
+ * "normalized" is the result of dividing "seq" by "gcd".
+ */
+struct {
+	char *seq[SEQ_LEN];
+	char *gcd;
+	char *normalized[SEQ_LEN];
+} seq_gcd_tests[] = {
+	{ { "6", "-9", "0", "15" }, "3", { "2", "-3", "0", "5" } },
+	{ { "0", "0", "0", "0" }, "0", { "0", "0", "0", "0" } },
+	{ { "2147483646", "0", "-1073741823", "0" }, "1073741823",
+	  { "2", "0", "-1", "0" } },
+	{ { "8589934592", "4", "0", "-8" }, "4",
+	  { "2147483648", "1", "0", "-2" } },
+	{ { "2147483647", "-2147483647", "1", "0" }, "1",
+	  { "2147483647", "-2147483647", "1", "0" } },
+};
+
+/* Check isl_seq_gcd and isl_seq_normalize on the inputs in seq_gcd_tests
+ * in both small and big representation.
+ */
+static void seq_test_gcd(isl_ctx *ctx)
+{
+	int i, j;
+	isl_int gcd, expected;
+	isl_int seq[SEQ_LEN];
+
+	isl_int_init(gcd);
+	isl_int_init(expected);
+	seq_init(seq);
+
+	for (i = 0; i < ARRAY_SIZE(seq_gcd_tests); ++i) {
+		isl_int_read(expected, seq_gcd_tests[i].gcd);
+		for (j = 0; j < 2; ++j) {
+			seq_read(seq, seq_gcd_tests[i].seq, j);
+			isl_seq_gcd(seq, SEQ_LEN, &gcd);
+			assert(isl_int_eq(gcd, expected));
+			isl_seq_normalize(ctx, seq, SEQ_LEN);
+			seq_check(seq, seq_gcd_tests[i].normalized);
+		}
+	}
+
+	isl_int_clear(gcd);
+	isl_int_clear(expected);
+	seq_clear(seq);
+}
+
+/* Inputs for isl_seq_eq tests.
+ * "equal" is set if "seq1" and "seq2" are equal.
+ */
+struct {
+	char *seq1[SEQ_LEN];
+	char *seq2[SEQ_LEN];
+	int equal;
+} seq_eq_tests[] = {
+	{ { "1", "-2", "0", "2147483647" }, { "1", "-2", "0", "2147483647" },
+	  1 },
+	{ { "1", "-2", "0", "2147483647" }, { "1", "-2", "0", "2147483646" },
+	  0 },
+	{ { "0", "0", "4294967296", "1" }, { "0", "0", "4294967296", "1" },
+	  1 },
+	{ { "0", "0", "4294967296", "1" }, { "0", "0", "4294967297", "1" },
+	  0 },
+};
+
+/* Check isl_seq_eq on the inputs in seq_eq_tests for all combinations
+ * of small and big representations of the inputs and
+ * check that equal sequences have the same hash value.
+ */
+static void seq_test_eq(void)
+{
+	int i, j;
+	isl_int seq1[SEQ_LEN], seq2[SEQ_LEN];
+
+	seq_init(seq1);
+	seq_init(seq2);
+
+	for (i = 0; i < ARRAY_SIZE(seq_eq_tests); ++i) {
+		for (j = 0; j < 4; ++j) {
+			seq_read(seq1, seq_eq_tests[i].seq1, j & 1);
+			seq_read(seq2, seq_eq_tests[i].seq2, j & 2);
+			assert(isl_seq_eq(seq1, seq2, SEQ_LEN) ==
+				seq_eq_tests[i].equal);
+			if (seq_eq_tests[i].equal)
+				assert(isl_seq_get_hash(seq1, SEQ_LEN) ==
+					isl_seq_get_hash(seq2, SEQ_LEN));
+		}
+	}
+
+	seq_clear(seq1);
+	seq_clear(seq2);
+}
+
+/* Tests the isl_seq_* functions that have a separate implementation
+ * for sequences of integers in small representation.
+ * If small integer optimization is enabled, the inputs are passed
+ * in both small and big representation such that both the special
+ * and the generic implementation are tested.
+ */
+static void seq_test(void)
+{
+	isl_ctx *ctx;
+
+	ctx = isl_ctx_alloc();
+	assert(ctx);
+
+	seq_test_combine();
+	seq_test_addmul();
+	seq_test_gcd(ctx);
+	seq_test_eq();
+
+	isl_ctx_free(ctx);
+}
+
 /* Tests the isl_int_* function to give the expected results. Tests are
  * grouped by the number of arguments they take.
  *
  * If small integer optimization is enabled, we also test whether the results
  * are the same in small and big representation.
+ * Finally, the isl_seq_* functions built on top of them are tested.
  */
 int main()
 {
@@ -622,5 +919,7 @@ int main()
 		    int_binary_tests[i].rhs, int_binary_tests[i].fn);
 	}
 
+	seq_test();
+
 	return 0;
 }
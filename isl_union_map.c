@@ -753,10 +753,17 @@ static __isl_give isl_union_map *union_map_gist_params(
 	return isl_union_map_gist_params(umap, isl_set_from_union_set(uset));
 }
 
+/* Data structure for use by match_bin_op and match_bin_entry.
+ *
+ * "umap2" is the union map that is not being iterated over.
+ * "swapped" is set if this is the first argument of the operation,
+ * i.e., if the iteration is performed over the second argument.
+ */
 struct isl_union_map_match_bin_data {
 	isl_union_map *umap2;
 	isl_union_map *res;
 	__isl_give isl_map *(*fn)(__isl_take isl_map*, __isl_take isl_map*);
+	int swapped;
 };
 
 static isl_stat match_bin_entry(void **entry, void *user)
@@ -773,8 +780,10 @@ static isl_stat match_bin_entry(void **entry, void *user)
 	if (!entry2)
 		return isl_stat_ok;
 
-	map = isl_map_copy(map);
-	map = data->fn(map, isl_map_copy(entry2->data));
+	if (data->swapped)
+		map = data->fn(isl_map_copy(entry2->data), isl_map_copy(map));
+	else
+		map = data->fn(isl_map_copy(map), isl_map_copy(entry2->data));
 
 	empty = isl_map_is_empty(map);
 	if (empty < 0) {
@@ -791,11 +800,21 @@ static isl_stat match_bin_entry(void **entry, void *user)
 	return isl_stat_ok;
 }
 
+/* Apply "fn" to each pair of maps in "umap1" and "umap2" that
+ * live in the same space and collect the non-empty results.
+ *
+ * Since only maps in the same space are combined, it does not
+ * matter which of the two union maps is iterated over.
+ * Iterate over the one with the fewest elements and
+ * look up the corresponding maps in the other one, while still passing
+ * the maps to "fn" in their original order.
+ */
 static __isl_give isl_union_map *match_bin_op(__isl_take isl_union_map *umap1,
 	__isl_take isl_union_map *umap2,
 	__isl_give isl_map *(*fn)(__isl_take isl_map*, __isl_take isl_map*))
 {
-	struct isl_union_map_match_bin_data data = { NULL, NULL, fn };
+	struct isl_union_map_match_bin_data data = { NULL, NULL, fn, 0 };
+	isl_union_map *iter;
 
 	umap1 = isl_union_map_align_params(umap1, isl_union_map_get_space(umap2));
 	umap2 = isl_union_map_align_params(umap2, isl_union_map_get_space(umap1));
@@ -803,10 +822,12 @@ static __isl_give isl_union_map *match_bin_op(__isl_take isl_union_map *umap1,
 	if (!umap1 || !umap2)
 		goto error;
 
-	data.umap2 = umap2;
+	data.swapped = umap2->table.n < umap1->table.n;
+	iter = data.swapped ? umap2 : umap1;
+	data.umap2 = data.swapped ? umap1 : umap2;
 	data.res = isl_union_map_alloc(isl_space_copy(umap1->dim),
 				       umap1->table.n);
-	if (isl_hash_table_foreach(umap1->dim->ctx, &umap1->table,
+	if (isl_hash_table_foreach(umap1->dim->ctx, &iter->table,
 				   &match_bin_entry, &data) < 0)
 		goto error;
 
@@ -1221,11 +1242,154 @@ __isl_give isl_union_map *isl_union_map_intersect_range(
 	return gen_bin_op(umap, uset, &intersect_range_entry);
 }
 
+/* An entry in an isl_union_map_tuple_index.
+ * "hash" is the hash value of the indexed tuple of "map" and
+ * "pos" is the position of "map" in the iteration order
+ * of the indexed union map.
+ */
+struct isl_union_map_tuple_index_entry {
+	uint32_t hash;
+	int pos;
+	isl_map *map;
+};
+
+/* An index on the maps of a union map, keyed on the tuple of type "type".
+ * The "n" elements of "entry" are sorted on hash value and,
+ * for equal hash values, on position such that maps with
+ * the same hash value are visited in their original order.
+ */
+struct isl_union_map_tuple_index {
+	enum isl_dim_type type;
+	int n;
+	struct isl_union_map_tuple_index_entry *entry;
+};
+
+/* Return the hash value of the tuple of type "type" of "space",
+ * i.e., the hash value of the domain or the range of "space".
+ */
+static uint32_t tuple_hash(__isl_keep isl_space *space,
+	enum isl_dim_type type)
+{
+	if (type == isl_dim_in)
+		return isl_space_get_domain_hash(space);
+	return isl_space_get_range_hash(space);
+}
+
+/* Add *entry to the isl_union_map_tuple_index "user".
+ */
+static isl_stat add_tuple_index_entry(void **entry, void *user)
+{
+	struct isl_union_map_tuple_index *index = user;
+	isl_map *map = *entry;
+	struct isl_union_map_tuple_index_entry *e;
+
+	e = &index->entry[index->n];
+	e->hash = tuple_hash(map->dim, index->type);
+	e->pos = index->n++;
+	e->map = map;
+
+	return isl_stat_ok;
+}
+
+/* Compare two entries of an isl_union_map_tuple_index
+ * on hash value and position.
+ */
+static int cmp_tuple_index_entry(const void *p1, const void *p2)
+{
+	const struct isl_union_map_tuple_index_entry *e1 = p1;
+	const struct isl_union_map_tuple_index_entry *e2 = p2;
+
+	if (e1->hash != e2->hash)
+		return e1->hash < e2->hash ? -1 : 1;
+	return e1->pos - e2->pos;
+}
+
+/* Construct an index on the maps of "umap" keyed on their tuples
+ * of type "type".
+ * The index only refers to the maps in "umap" and therefore
+ * needs to be cleared before "umap" is modified or freed.
+ */
+static isl_stat tuple_index_init(struct isl_union_map_tuple_index *index,
+	__isl_keep isl_union_map *umap, enum isl_dim_type type)
+{
+	isl_ctx *ctx;
+
+	index->type = type;
+	index->n = 0;
+	index->entry = NULL;
+	if (!umap)
+		return isl_stat_error;
+	if (umap->table.n == 0)
+		return isl_stat_ok;
+
+	ctx = isl_union_map_get_ctx(umap);
+	index->entry = isl_alloc_array(ctx,
+			struct isl_union_map_tuple_index_entry, umap->table.n);
+	if (!index->entry)
+		return isl_stat_error;
+	if (isl_hash_table_foreach(ctx, &umap->table,
+				    &add_tuple_index_entry, index) < 0)
+		return isl_stat_error;
+	qsort(index->entry, index->n, sizeof(index->entry[0]),
+		&cmp_tuple_index_entry);
+
+	return isl_stat_ok;
+}
+
+static void tuple_index_clear(struct isl_union_map_tuple_index *index)
+{
+	free(index->entry);
+	index->entry = NULL;
+	index->n = 0;
+}
+
+/* Call "fn" on each map in "index" with a tuple hash value equal to "hash".
+ * Since different tuples may have the same hash value,
+ * "fn" still needs to check whether the tuples actually match.
+ */
+static isl_stat tuple_index_foreach(struct isl_union_map_tuple_index *index,
+	uint32_t hash, isl_stat (*fn)(void **entry, void *user), void *user)
+{
+	int lo, hi;
+
+	lo = 0;
+	hi = index->n;
+	while (lo < hi) {
+		int mid = lo + (hi - lo) / 2;
+
+		if (index->entry[mid].hash < hash)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	for (; lo < index->n && index->entry[lo].hash == hash; ++lo) {
+		void **entry = (void **) &index->entry[lo].map;
+
+		if (fn(entry, user) < 0)
+			return isl_stat_error;
+	}
+
+	return isl_stat_ok;
+}
+
+/* Data structure for use by bin_op and bin_entry.
+ *
+ * If "indexed" is set, then "fn" only needs to be called on pairs
+ * of maps where the tuple of type "type1" of the map from the first
+ * union map is equal to the tuple of type "type2" of the map
+ * from the second union map and "index" is an index on the maps
+ * of the second union map keyed on the tuples of type "type2".
+ * Otherwise, "fn" is called on all pairs.
+ */
 struct isl_union_map_bin_data {
 	isl_union_map *umap2;
 	isl_union_map *res;
 	isl_map *map;
 	isl_stat (*fn)(void **entry, void *user);
+	int indexed;
+	enum isl_dim_type type1;
+	struct isl_union_map_tuple_index index;
 };
 
 static isl_stat apply_range_entry(void **entry, void *user)
@@ -1255,12 +1419,20 @@ static isl_stat apply_range_entry(void **entry, void *user)
 	return isl_stat_ok;
 }
 
+/* Call data->fn on each map in data->umap2 that may need to be
+ * combined with *entry.
+ */
 static isl_stat bin_entry(void **entry, void *user)
 {
 	struct isl_union_map_bin_data *data = user;
 	isl_map *map = *entry;
+	uint32_t hash;
 
 	data->map = map;
+	if (data->indexed) {
+		hash = tuple_hash(map->dim, data->type1);
+		return tuple_index_foreach(&data->index, hash, data->fn, data);
+	}
 	if (isl_hash_table_foreach(data->umap2->dim->ctx, &data->umap2->table,
 				   data->fn, data) < 0)
 		return isl_stat_error;
@@ -1268,39 +1440,79 @@ static isl_stat bin_entry(void **entry, void *user)
 	return isl_stat_ok;
 }
 
-static __isl_give isl_union_map *bin_op(__isl_take isl_union_map *umap1,
-	__isl_take isl_union_map *umap2,
-	isl_stat (*fn)(void **entry, void *user))
+/* Call data->fn on the pairs of maps in "umap1" and "umap2"
+ * described by "data" and return the collected results.
+ * If data->indexed is set, then an index is constructed
+ * on the maps of "umap2" keyed on their tuples of type "type2".
+ */
+static __isl_give isl_union_map *gen_bin_pair_op(
+	__isl_take isl_union_map *umap1, __isl_take isl_union_map *umap2,
+	struct isl_union_map_bin_data *data, enum isl_dim_type type2)
 {
-	struct isl_union_map_bin_data data = { NULL, NULL, NULL, fn };
-
 	umap1 = isl_union_map_align_params(umap1, isl_union_map_get_space(umap2));
 	umap2 = isl_union_map_align_params(umap2, isl_union_map_get_space(umap1));
 
 	if (!umap1 || !umap2)
 		goto error;
 
-	data.umap2 = umap2;
-	data.res = isl_union_map_alloc(isl_space_copy(umap1->dim),
+	data->umap2 = umap2;
+	data->res = isl_union_map_alloc(isl_space_copy(umap1->dim),
 				       umap1->table.n);
+	if (data->indexed &&
+	    tuple_index_init(&data->index, umap2, type2) < 0)
+		goto error;
 	if (isl_hash_table_foreach(umap1->dim->ctx, &umap1->table,
-				   &bin_entry, &data) < 0)
+				   &bin_entry, data) < 0)
 		goto error;
 
+	tuple_index_clear(&data->index);
 	isl_union_map_free(umap1);
 	isl_union_map_free(umap2);
-	return data.res;
+	return data->res;
 error:
+	tuple_index_clear(&data->index);
 	isl_union_map_free(umap1);
 	isl_union_map_free(umap2);
-	isl_union_map_free(data.res);
+	isl_union_map_free(data->res);
 	return NULL;
 }
 
+/* Call "fn" on all pairs of maps in "umap1" and "umap2" and
+ * return the collected results.
+ */
+static __isl_give isl_union_map *bin_op(__isl_take isl_union_map *umap1,
+	__isl_take isl_union_map *umap2,
+	isl_stat (*fn)(void **entry, void *user))
+{
+	struct isl_union_map_bin_data data = { NULL, NULL, NULL, fn, 0,
+		isl_dim_all, { isl_dim_all, 0, NULL } };
+
+	return gen_bin_pair_op(umap1, umap2, &data, isl_dim_all);
+}
+
+/* Call "fn" on the pairs of maps in "umap1" and "umap2"
+ * for which the tuple of type "type1" of the first is equal
+ * to the tuple of type "type2" of the second and
+ * return the collected results.
+ * "fn" is only called on pairs of maps with equal tuple hash values,
+ * which are found through an index on the maps of "umap2".
+ */
+static __isl_give isl_union_map *tuple_bin_op(__isl_take isl_union_map *umap1,
+	__isl_take isl_union_map *umap2,
+	enum isl_dim_type type1, enum isl_dim_type type2,
+	isl_stat (*fn)(void **entry, void *user))
+{
+	struct isl_union_map_bin_data data = { NULL, NULL, NULL, fn, 1,
+		type1, { type2, 0, NULL } };
+
+	return gen_bin_pair_op(umap1, umap2, &data, type2);
+}
+
 __isl_give isl_union_map *isl_union_map_apply_range(
 	__isl_take isl_union_map *umap1, __isl_take isl_union_map *umap2)
 {
-	return bin_op(umap1, umap2, &apply_range_entry);
+	return tuple_bin_op(umap1, umap2, isl_dim_out, isl_dim_in,
+				&apply_range_entry);
 }
 
 __isl_give isl_union_map *isl_union_map_apply_domain(
@@ -1336,7 +1548,8 @@ static isl_stat map_lex_lt_entry(void **entry, void *user)
 __isl_give isl_union_map *isl_union_map_lex_lt_union_map(
 	__isl_take isl_union_map *umap1, __isl_take isl_union_map *umap2)
 {
-	return bin_op(umap1, umap2, &map_lex_lt_entry);
+	return tuple_bin_op(umap1, umap2, isl_dim_out, isl_dim_out,
+				&map_lex_lt_entry);
 }
 
 static isl_stat map_lex_le_entry(void **entry, void *user)
@@ -1358,7 +1571,8 @@ static isl_stat map_lex_le_entry(void **entry, void *user)
 __isl_give isl_union_map *isl_union_map_lex_le_union_map(
 	__isl_take isl_union_map *umap1, __isl_take isl_union_map *umap2)
 {
-	return bin_op(umap1, umap2, &map_lex_le_entry);
+	return tuple_bin_op(umap1, umap2, isl_dim_out, isl_dim_out,
+				&map_lex_le_entry);
 }
 
 static isl_stat product_entry(void **entry, void *user)
@@ -1419,7 +1633,8 @@ static isl_stat domain_product_entry(void **entry, void *user)
 __isl_give isl_union_map *isl_union_map_domain_product(
 	__isl_take isl_union_map *umap1, __isl_take isl_union_map *umap2)
 {
-	return bin_op(umap1, umap2, &domain_product_entry);
+	return tuple_bin_op(umap1, umap2, isl_dim_out, isl_dim_out,
+				&domain_product_entry);
 }
 
 static isl_stat range_product_entry(void **entry, void *user)
@@ -1442,7 +1657,8 @@ static isl_stat range_product_entry(void **entry, void *user)
 __isl_give isl_union_map *isl_union_map_range_product(
 	__isl_take isl_union_map *umap1, __isl_take isl_union_map *umap2)
 {
-	return bin_op(umap1, umap2, &range_product_entry);
+	return tuple_bin_op(umap1, umap2, isl_dim_in, isl_dim_in,
+				&range_product_entry);
 }
 
 /* If data->map A -> B and "map2" C -> D have the same range space,
@@ -1470,7 +1686,8 @@ static isl_stat flat_domain_product_entry(void **entry, void *user)
 __isl_give isl_union_map *isl_union_map_flat_domain_product(
 	__isl_take isl_union_map *umap1, __isl_take isl_union_map *umap2)
 {
-	return bin_op(umap1, umap2, &flat_domain_product_entry);
+	return tuple_bin_op(umap1, umap2, isl_dim_out, isl_dim_out,
+				&flat_domain_product_entry);
 }
 
 static isl_stat flat_range_product_entry(void **entry, void *user)
@@ -1493,7 +1710,8 @@ static isl_stat flat_range_product_entry(void **entry, void *user)
 __isl_give isl_union_map *isl_union_map_flat_range_product(
 	__isl_take isl_union_map *umap1, __isl_take isl_union_map *umap2)
 {
-	return bin_op(umap1, umap2, &flat_range_product_entry);
+	return tuple_bin_op(umap1, umap2, isl_dim_in, isl_dim_in,
+				&flat_range_product_entry);
 }
 
 static __isl_give isl_union_set *cond_un_op(__isl_take isl_union_map *umap,
@@ -3493,57 +3711,83 @@ __isl_give isl_union_map *isl_union_map_preimage_domain_multi_pw_aff(
 
 /* Internal data structure for preimage_upma.
  *
- * "umap" is the map of which the preimage should be computed.
- * "res" collects the results.
- * "fn" computes the preimage for a given piecewise multi-affine function.
+ * "index" is an index on the maps of which the preimage should be computed,
+ * keyed on the tuple that gets replaced by the preimage.
+ * "preimage" is used for computing the preimage under
+ * a single piecewise multi-affine function and collects the results.
  */
 struct isl_union_map_preimage_upma_data {
-	isl_union_map *umap;
-	isl_union_map *res;
-	__isl_give isl_union_map *(*fn)(__isl_take isl_union_map *umap,
-		__isl_take isl_pw_multi_aff *pma);
+	struct isl_union_map_tuple_index index;
+	struct isl_union_map_preimage_data preimage;
 };
 
-/* Call data->fn to compute the preimage of the domain or range of data->umap
- * under the function represented by pma and add the result to data->res.
+/* Compute the preimage of the domain or range of the maps in data->index
+ * that match the target space of "pma" under the function represented
+ * by "pma" and add the results to data->preimage.res.
+ * Only the maps with a matching tuple hash value are considered.
  */
 static isl_stat preimage_upma(__isl_take isl_pw_multi_aff *pma, void *user)
 {
 	struct isl_union_map_preimage_upma_data *data = user;
-	isl_union_map *umap;
+	uint32_t hash;
+	isl_stat r;
 
-	umap = isl_union_map_copy(data->umap);
-	umap = data->fn(umap, pma);
-	data->res = isl_union_map_union(data->res, umap);
+	data->preimage.space = isl_pw_multi_aff_get_space(pma);
+	data->preimage.pma = pma;
+	hash = isl_space_get_range_hash(data->preimage.space);
+	r = tuple_index_foreach(&data->index, hash,
+				&preimage_entry, &data->preimage);
+	isl_space_free(data->preimage.space);
+	isl_pw_multi_aff_free(pma);
 
-	return data->res ? isl_stat_ok : isl_stat_error;
+	return r;
 }
 
 /* Compute the preimage of the domain or range of "umap" under the function
  * represented by "upma".
  * In other words, plug in "upma" in the domain or range of "umap".
- * The function "fn" performs the actual preimage computation
- * on a piecewise multi-affine function.
+ * The function "fn" performs the actual preimage computation on a map,
+ * while "match" determines to which maps the function should be applied.
+ * "type" is the type of the tuple that is checked by "match".
+ *
+ * Rather than considering every map of "umap" for each element of "upma",
+ * the maps of "umap" are indexed on the tuple of type "type",
+ * such that each element of "upma" only visits the maps that
+ * may match its target space.
  */
 static __isl_give isl_union_map *preimage_union_pw_multi_aff(
 	__isl_take isl_union_map *umap,
-	__isl_take isl_union_pw_multi_aff *upma,
-	__isl_give isl_union_map *(*fn)(__isl_take isl_union_map *umap,
+	__isl_take isl_union_pw_multi_aff *upma, enum isl_dim_type type,
+	int (*match)(__isl_keep isl_map *map, __isl_keep isl_space *space),
+	__isl_give isl_map *(*fn)(__isl_take isl_map *map,
 		__isl_take isl_pw_multi_aff *pma))
 {
 	struct isl_union_map_preimage_upma_data data;
 
-	data.umap = umap;
-	data.res = isl_union_map_empty(isl_union_map_get_space(umap));
-	data.fn = fn;
-	if (isl_union_pw_multi_aff_foreach_pw_multi_aff(upma,
+	umap = isl_union_map_align_params(umap,
+				isl_union_pw_multi_aff_get_space(upma));
+	upma = isl_union_pw_multi_aff_align_params(upma,
+				isl_union_map_get_space(umap));
+	if (!umap || !upma)
+		goto error;
+
+	data.preimage.res = isl_union_map_empty(isl_union_map_get_space(umap));
+	data.preimage.match = match;
+	data.preimage.fn = fn;
+	if (tuple_index_init(&data.index, umap, type) < 0 ||
+	    isl_union_pw_multi_aff_foreach_pw_multi_aff(upma,
 						    &preimage_upma, &data) < 0)
-		data.res = isl_union_map_free(data.res);
+		data.preimage.res = isl_union_map_free(data.preimage.res);
 
+	tuple_index_clear(&data.index);
 	isl_union_map_free(umap);
 	isl_union_pw_multi_aff_free(upma);
 
-	return data.res;
+	return data.preimage.res;
+error:
+	isl_union_map_free(umap);
+	isl_union_pw_multi_aff_free(upma);
+	return NULL;
 }
 
 /* Compute the preimage of the domain of "umap" under the function
@@ -3558,8 +3802,8 @@ __isl_give isl_union_map *isl_union_map_preimage_domain_union_pw_multi_aff(
 	__isl_take isl_union_map *umap,
 	__isl_take isl_union_pw_multi_aff *upma)
 {
-	return preimage_union_pw_multi_aff(umap, upma,
-				&isl_union_map_preimage_domain_pw_multi_aff);
+	return preimage_union_pw_multi_aff(umap, upma, isl_dim_in,
+			&domain_match, &isl_map_preimage_domain_pw_multi_aff);
 }
 
 /* Compute the preimage of the range of "umap" under the function
@@ -3574,8 +3818,8 @@ __isl_give isl_union_map *isl_union_map_preimage_range_union_pw_multi_aff(
 	__isl_take isl_union_map *umap,
 	__isl_take isl_union_pw_multi_aff *upma)
 {
-	return preimage_union_pw_multi_aff(umap, upma,
-				&isl_union_map_preimage_range_pw_multi_aff);
+	return preimage_union_pw_multi_aff(umap, upma, isl_dim_out,
+			&range_match, &isl_map_preimage_range_pw_multi_aff);
 }
 
 /* Compute the preimage of "uset" under the function represented by "upma".
@@ -3589,8 +3833,8 @@ __isl_give isl_union_set *isl_union_set_preimage_union_pw_multi_aff(
 	__isl_take isl_union_set *uset,
 	__isl_take isl_union_pw_multi_aff *upma)
 {
-	return preimage_union_pw_multi_aff(uset, upma,
-					&isl_union_set_preimage_pw_multi_aff);
+	return preimage_union_pw_multi_aff(uset, upma, isl_dim_set,
+			&set_match, &isl_set_preimage_pw_multi_aff);
 }
 
 /* Reset the user pointer on all identifiers of parameters and tuples
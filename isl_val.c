@@ -383,6 +383,7 @@ uint32_t isl_val_get_hash(__isl_keep isl_val *val)
  */
 __isl_give isl_val *isl_val_normalize(__isl_take isl_val *v)
 {
+	isl_int local, *gcd;
 	isl_ctx *ctx;
 
 	if (!v)
@@ -396,11 +397,13 @@ __isl_give isl_val *isl_val_normalize(__isl_take isl_val *v)
 		isl_int_neg(v->n, v->n);
 	}
 	ctx = isl_val_get_ctx(v);
-	isl_int_gcd(ctx->normalize_gcd, v->n, v->d);
-	if (isl_int_is_one(ctx->normalize_gcd))
-		return v;
-	isl_int_divexact(v->n, v->n, ctx->normalize_gcd);
-	isl_int_divexact(v->d, v->d, ctx->normalize_gcd);
+	gcd = isl_ctx_get_normalize_gcd(ctx, &local);
+	isl_int_gcd(*gcd, v->n, v->d);
+	if (!isl_int_is_one(*gcd)) {
+		isl_int_divexact(v->n, v->n, *gcd);
+		isl_int_divexact(v->d, v->d, *gcd);
+	}
+	isl_ctx_release_normalize_gcd(ctx, gcd);
 	return v;
 }
 